@@ -0,0 +1,176 @@
+/**
+ Business days: days that are neither Shabbat nor Yom Tov.
+
+ Each Hebrew year is represented by a bitmap of its non-working days, one bit
+ per day from Rosh Hashana, with the count of non-working days before each
+ 64-bit word. Shabbatot are filled in a word at a time from the weekday of
+ Rosh Hashana, Yamim Tovim from the year layout. Counting (rank) and finding
+ the n-th working day (select) then take a fixed number of word operations
+ per year, whatever the number of days.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdint.h>
+
+/** Words of bitmap per year; the longest year has 385 days */
+#define YEAR_WORDS 7
+
+/** Bits 0, 7, 14, ... 63: every seventh day of a word */
+#define WEEKLY_PATTERN 0x8102040810204081ULL
+
+typedef struct business_year_s {
+	heb_year_layout layout;
+	int length;
+	uint64_t off[YEAR_WORDS];      /* bit set: not a working day; also set past year end */
+	int off_before[YEAR_WORDS + 1]; /* non-working days before each word */
+} business_year;
+
+/* Yamim Tovim on which work is forbidden, as month and day */
+static const int YOM_TOV[][2] = {
+	{7, 1}, {7, 2}, {7, 10}, {7, 15}, {7, 22}, {1, 15}, {1, 21}, {3, 6}
+};
+
+/* second days of Yom Tov kept outside of Israel */
+static const int YOM_TOV_SHENI[][2] = {
+	{7, 16}, {7, 23}, {1, 16}, {1, 22}, {3, 7}
+};
+
+static void set_off(business_year *by, const int month, const int day)
+{
+	int i;
+	for (i = 0; i < by->layout.months; i++) {
+		if (by->layout.month[i] == month) {
+			hc_abs_day d = by->layout.month_start[i] + day - 1 - by->layout.rosh_hashana;
+			by->off[d / 64] |= 1ULL << (d % 64);
+			return;
+		}
+	}
+}
+
+static void business_year_init(business_year *by, const hc_holiday_region region)
+{
+	const int rh_dow = (by->layout.rosh_hashana - 1) % 7;
+	int w, i;
+
+	by->length = by->layout.next_rosh_hashana - by->layout.rosh_hashana;
+	for (w = 0; w < YEAR_WORDS; w++) {
+		/* 64 = 1 mod 7, so each word starts one weekday later than the previous */
+		const int first_dow = (rh_dow + w) % 7;
+		by->off[w] = WEEKLY_PATTERN << ((SATURDAY - first_dow + 7) % 7);
+		if (by->length < 64 * (w + 1))
+			by->off[w] |= by->length <= 64 * w ? ~0ULL : ~0ULL << (by->length - 64 * w);
+	}
+	for (i = 0; i < (int)(sizeof(YOM_TOV) / sizeof(YOM_TOV[0])); i++)
+		set_off(by, YOM_TOV[i][0], YOM_TOV[i][1]);
+	if (region == HOLIDAYS_DIASPORA) {
+		for (i = 0; i < (int)(sizeof(YOM_TOV_SHENI) / sizeof(YOM_TOV_SHENI[0])); i++)
+			set_off(by, YOM_TOV_SHENI[i][0], YOM_TOV_SHENI[i][1]);
+	}
+	by->off_before[0] = 0;
+	for (w = 0; w < YEAR_WORDS; w++)
+		by->off_before[w + 1] = by->off_before[w] + __builtin_popcountll(by->off[w]);
+}
+
+static void business_year_first(business_year *by, const int year, const hc_holiday_region region)
+{
+	heb_year_layout_init(&by->layout, year);
+	business_year_init(by, region);
+}
+
+static void business_year_next(business_year *by, const hc_holiday_region region)
+{
+	heb_year_layout_next(&by->layout);
+	business_year_init(by, region);
+}
+
+/* rank: working days among the first n days of the year */
+static int working_before(const business_year *by, const int n)
+{
+	const int w = n / 64, b = n % 64;
+	int off = by->off_before[w];
+	if (b)
+		off += __builtin_popcountll(by->off[w] & ((1ULL << b) - 1));
+	return n - off;
+}
+
+/* select: day of the year of the k-th working day (k >= 1), at or after day 0 */
+static int select_working(const business_year *by, int k)
+{
+	int w;
+	uint64_t on;
+
+	for (w = 0; w < YEAR_WORDS; w++) {
+		int n = 64 - __builtin_popcountll(by->off[w]);
+		if (k <= n)
+			break;
+		k -= n;
+	}
+	on = ~by->off[w];
+	while (--k > 0)
+		on &= on - 1;
+	return 64 * w + __builtin_ctzll(on);
+}
+
+static int heb_year_of(const hc_abs_day abs_date)
+{
+	hc_date d;
+	if (hc_set_abs_date(&d, abs_date, HEBREW) != 0)
+		return -1;
+	return d.year;
+}
+
+int hc_is_business_day(const hc_abs_day abs_date, const hc_holiday_region region)
+{
+	business_year by;
+	const int year = heb_year_of(abs_date);
+	hc_abs_day d;
+
+	if (year < 1)
+		return -1;
+	business_year_first(&by, year, region);
+	d = abs_date - by.layout.rosh_hashana;
+	return !((by.off[d / 64] >> (d % 64)) & 1);
+}
+
+hc_abs_day hc_count_business_days(const hc_abs_day from_abs, const hc_abs_day to_abs, const hc_holiday_region region)
+{
+	business_year by;
+	const int year = heb_year_of(from_abs);
+	hc_abs_day count = 0;
+
+	if (year < 1 || to_abs < from_abs)
+		return -1;
+	business_year_first(&by, year, region);
+	for (;;) {
+		const hc_abs_day start = by.layout.rosh_hashana;
+		const int a = from_abs > start ? (int)(from_abs - start) : 0;
+		const int b = to_abs < start + by.length ? (int)(to_abs - start) + 1 : by.length;
+		count += working_before(&by, b) - working_before(&by, a);
+		if (to_abs < start + by.length)
+			return count;
+		business_year_next(&by, region);
+	}
+}
+
+hc_abs_day hc_add_business_days(const hc_abs_day from_abs, hc_abs_day n, const hc_holiday_region region)
+{
+	business_year by;
+	const int year = heb_year_of(from_abs);
+	int done;
+
+	if (year < 1 || n < 0)
+		return -1;
+	if (n == 0)
+		return from_abs;
+	business_year_first(&by, year, region);
+	/* working days of this year up to and including from_abs don't count */
+	done = working_before(&by, (int)(from_abs - by.layout.rosh_hashana) + 1);
+	for (;;) {
+		const int total = working_before(&by, by.length);
+		if (done + n <= total)
+			return by.layout.rosh_hashana + select_working(&by, (int)(done + n));
+		n -= total - done;
+		done = 0;
+		business_year_next(&by, region);
+	}
+}
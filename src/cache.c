@@ -0,0 +1,147 @@
+/**
+ Cache of results for repeated calls with the same input.
+
+ Every thread has its own table of HC_CACHE_SLOTS entries, so no locking is
+ needed, and turns it on and off for itself. The table is allocated the first
+ time the thread makes a call with the cache on, and freed by hc_cache_clear
+ or when the thread exits; a thread that never turns the cache on pays for
+ a few words of thread-local storage only. The input of a call (which
+ function, the calendar, year, month and day, and the target calendar) is
+ packed into a 64 bit key, hashed, and looked up by linear probing over at
+ most CACHE_PROBES slots. When all of them are taken, the first one is
+ overwritten: the table never grows, and an entry lost only costs a miss.
+
+ Registering a calendar may change any result, so it empties the tables of
+ all threads, lazily, by bumping an atomic generation number that each
+ lookup checks.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Slots tried for a key before giving up and overwriting the first */
+#define CACHE_PROBES 8
+
+/** Marks a slot in use; keys of all calls have it set */
+#define KEY_USED (1ULL << 63)
+
+/** log2 of HC_CACHE_SLOTS: bits of the hash that pick a slot */
+#define CACHE_BITS 12
+_Static_assert(1 << CACHE_BITS == HC_CACHE_SLOTS, "CACHE_BITS must match HC_CACHE_SLOTS");
+
+typedef struct cache_thread_s {
+	int enabled;
+	unsigned generation;
+	hc_cache_stats stats;
+	hc_cache_entry *slots;   /* HC_CACHE_SLOTS entries, allocated on first use */
+} cache_thread;
+
+static _Thread_local cache_thread table;
+
+/* frees the slots of a thread when it exits */
+static pthread_key_t slots_key;
+static pthread_once_t slots_key_once = PTHREAD_ONCE_INIT;
+
+_Atomic unsigned cache_generation;
+
+static void create_slots_key(void)
+{
+	pthread_key_create(&slots_key, free);
+}
+
+void hc_cache_enable(const int on)
+{
+	table.enabled = on;
+}
+
+int hc_cache_is_enabled(void)
+{
+	return table.enabled;
+}
+
+void hc_cache_get_stats(hc_cache_stats *stats)
+{
+	*stats = table.stats;
+}
+
+void hc_cache_clear(void)
+{
+	if (table.slots != NULL) {
+		free(table.slots);
+		table.slots = NULL;
+		pthread_setspecific(slots_key, NULL);
+	}
+	memset(&table.stats, 0, sizeof(table.stats));
+}
+
+/* first slot to probe for a key */
+static size_t key_slot(const uint64_t key)
+{
+	/* Fibonacci hashing: the top CACHE_BITS bits of the key times 2^64 / phi */
+	return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - CACHE_BITS));
+}
+
+hc_cache_entry *cache_find(const cache_kind kind, const int calendar, const int year,
+		const int month, const int day, const int target, uint64_t *key)
+{
+	unsigned generation;
+	size_t h, i;
+
+	*key = 0;
+	if (!table.enabled)
+		return NULL;
+	/* inputs that do not fit the key cannot be valid, and are not cached */
+	if ((unsigned)calendar >= HC_MAX_CALENDARS || (unsigned)target >= HC_MAX_CALENDARS
+			|| (unsigned)month > 15 || (unsigned)day > 31)
+		return NULL;
+	generation = atomic_load_explicit(&cache_generation, memory_order_acquire);
+	if (table.slots == NULL) {
+		/* without memory the call just goes uncached */
+		table.slots = calloc(HC_CACHE_SLOTS, sizeof(hc_cache_entry));
+		if (table.slots == NULL)
+			return NULL;
+		pthread_once(&slots_key_once, create_slots_key);
+		pthread_setspecific(slots_key, table.slots);
+		table.generation = generation;
+	} else if (table.generation != generation) {
+		memset(table.slots, 0, HC_CACHE_SLOTS * sizeof(hc_cache_entry));
+		table.generation = generation;
+	}
+
+	/* year in bits 0-31, then 4 bits of month, 5 of day, 4 of each calendar */
+	*key = KEY_USED | (uint64_t)(uint32_t)year | (uint64_t)month << 32 | (uint64_t)day << 36
+		| (uint64_t)target << 41 | (uint64_t)calendar << 45 | (uint64_t)kind << 49;
+	h = key_slot(*key);
+
+	table.stats.lookups++;
+	for (i = 0; i < CACHE_PROBES; i++) {
+		hc_cache_entry *e = &table.slots[(h + i) % HC_CACHE_SLOTS];
+		if (e->key == *key) {
+			table.stats.hits++;
+			return e;
+		}
+		if (e->key == 0)
+			break;
+	}
+	return NULL;
+}
+
+hc_cache_entry *cache_slot(const uint64_t key)
+{
+	const size_t h = key_slot(key);
+	size_t i;
+
+	for (i = 0; i < CACHE_PROBES; i++) {
+		hc_cache_entry *e = &table.slots[(h + i) % HC_CACHE_SLOTS];
+		if (e->key == 0 || e->key == key) {
+			e->key = key;
+			return e;
+		}
+	}
+	table.stats.evictions++;
+	table.slots[h].key = key;
+	return &table.slots[h];
+}
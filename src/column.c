@@ -0,0 +1,410 @@
+/**
+ Columnar storage of dates.
+
+ A column keeps absolute days in blocks of HC_COLUMN_BLOCK rows. Each block
+ is encoded by its first day and the differences between consecutive rows,
+ stored relative to the smallest of them (a frame of reference) and
+ bit-packed at the width the largest one needs. Mostly sorted, clustered
+ dates thus take a few bits a row. The packed words of every block start on
+ a word boundary, so any block decodes on its own, and the index of blocks
+ keeps the smallest and largest day of each for range scans to skip.
+
+ Decoding into a calendar goes through a cache of the current year (its
+ first and last day, and for the Hebrew calendar the layout of its months),
+ which the dates of a block seldom leave.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Stored form: magic, rows and blocks, then one header per block and the words */
+static const unsigned char COLUMN_MAGIC[4] = { 'H', 'C', 'C', '1' };
+#define STORED_HEADER 20
+#define STORED_BLOCK 33
+
+/* rows in a block; all blocks but the last are full */
+static size_t block_rows(const hc_column *col, const size_t b)
+{
+	return b + 1 < col->blocks ? HC_COLUMN_BLOCK : col->rows - b * HC_COLUMN_BLOCK;
+}
+
+/* words taken by the packed differences of a block */
+static size_t block_words(const size_t rows, const int width)
+{
+	return ((rows - 1) * (size_t)width + 63) / 64;
+}
+
+static void encode_block(hc_column *col, hc_column_block *blk, const hc_abs_day *days, const size_t n)
+{
+	uint64_t *w = col->data + col->words;
+	hc_abs_day min = days[0], max = days[0], min_delta = 0, max_delta = 0;
+	uint64_t range;
+	size_t i, bit;
+	int width = 0;
+
+	for (i = 1; i < n; i++) {
+		const hc_abs_day delta = days[i] - days[i - 1];
+		if (i == 1 || delta < min_delta)
+			min_delta = delta;
+		if (i == 1 || delta > max_delta)
+			max_delta = delta;
+		if (days[i] < min)
+			min = days[i];
+		if (days[i] > max)
+			max = days[i];
+	}
+	range = (uint64_t)(max_delta - min_delta);
+	while (width < 64 && (range >> width) != 0)
+		width++;
+
+	blk->min = min;
+	blk->max = max;
+	blk->first = days[0];
+	blk->min_delta = min_delta;
+	blk->offset = col->words;
+	blk->width = width;
+	if (width == 0)
+		return;
+
+	for (i = 1, bit = 0; i < n; i++, bit += width) {
+		const uint64_t x = (uint64_t)(days[i] - days[i - 1] - min_delta);
+		const size_t k = bit / 64, s = bit % 64;
+		w[k] |= x << s;
+		if (s + width > 64)
+			w[k + 1] |= x >> (64 - s);
+	}
+	col->words += block_words(n, width);
+}
+
+static void decode_block(const hc_column *col, const size_t b, hc_abs_day *out)
+{
+	const hc_column_block *blk = &col->index[b];
+	const uint64_t *w = col->data + blk->offset;
+	const size_t n = block_rows(col, b);
+	const int width = blk->width;
+	const uint64_t mask = (1ULL << width) - 1;
+	hc_abs_day day = blk->first;
+	size_t i, bit;
+
+	out[0] = day;
+	if (width == 0) {
+		for (i = 1; i < n; i++)
+			out[i] = day += blk->min_delta;
+		return;
+	}
+	for (i = 1, bit = 0; i < n; i++, bit += width) {
+		const size_t k = bit / 64, s = bit % 64;
+		uint64_t x = w[k] >> s;
+		if (s + width > 64)
+			x |= w[k + 1] << (64 - s);
+		out[i] = day += blk->min_delta + (hc_abs_day)(x & mask);
+	}
+}
+
+/* allocate a column of the given number of rows, with room for the widest blocks */
+static int column_alloc(hc_column *col, const size_t rows, const size_t words)
+{
+	col->rows = rows;
+	col->blocks = (rows + HC_COLUMN_BLOCK - 1) / HC_COLUMN_BLOCK;
+	col->words = 0;
+	col->index = malloc((col->blocks ? col->blocks : 1) * sizeof(hc_column_block));
+	/* one spare word: decoding may read the word after the last one of a block */
+	col->data = calloc(words + 1, sizeof(uint64_t));
+	if (col->index == NULL || col->data == NULL) {
+		hc_column_free(col);
+		return -1;
+	}
+	return 0;
+}
+
+int hc_column_encode_abs(hc_column *col, const hc_abs_day *days, const size_t rows)
+{
+	size_t b, i;
+	uint64_t *data;
+
+	if (col == NULL || (days == NULL && rows > 0))
+		return -1;
+	for (i = 0; i < rows; i++) {
+		if (days[i] < 1 || days[i] > HC_MAX_ABS_DATE)
+			return -1;
+	}
+	/* days are at most 2^39 apart: 40 bits a row is the worst case */
+	if (column_alloc(col, rows, block_words(HC_COLUMN_BLOCK, 40)
+			* ((rows + HC_COLUMN_BLOCK - 1) / HC_COLUMN_BLOCK)) != 0)
+		return -1;
+	for (b = 0; b < col->blocks; b++)
+		encode_block(col, &col->index[b], days + b * HC_COLUMN_BLOCK, block_rows(col, b));
+
+	data = realloc(col->data, (col->words + 1) * sizeof(uint64_t));
+	if (data != NULL)
+		col->data = data;
+	return 0;
+}
+
+int hc_column_encode(hc_column *col, const hc_date *dates, const size_t rows)
+{
+	hc_abs_day *days;
+	size_t i;
+	int ret;
+
+	if (col == NULL || (dates == NULL && rows > 0))
+		return -1;
+	days = malloc((rows ? rows : 1) * sizeof(hc_abs_day));
+	if (days == NULL)
+		return -1;
+	for (i = 0; i < rows; i++) {
+		hc_cal_impl *impl = get_calendar(dates[i].calendar_type);
+		if (impl == NULL || !impl->check_date(dates[i].year, dates[i].month, dates[i].day)) {
+			free(days);
+			return -1;
+		}
+		days[i] = impl->abs_date(dates[i].year, dates[i].month, dates[i].day);
+	}
+	ret = hc_column_encode_abs(col, days, rows);
+	free(days);
+	return ret;
+}
+
+void hc_column_free(hc_column *col)
+{
+	if (col == NULL)
+		return;
+	free(col->index);
+	free(col->data);
+	col->index = NULL;
+	col->data = NULL;
+	col->rows = col->blocks = col->words = 0;
+}
+
+static unsigned char *put_u64(unsigned char *p, const uint64_t v)
+{
+	int i;
+	for (i = 0; i < 8; i++)
+		*p++ = (unsigned char)(v >> (8 * i));
+	return p;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+	uint64_t v = 0;
+	int i;
+	for (i = 0; i < 8; i++)
+		v |= (uint64_t)p[i] << (8 * i);
+	return v;
+}
+
+size_t hc_column_stored_size(const hc_column *col)
+{
+	return STORED_HEADER + STORED_BLOCK * col->blocks + 8 * col->words;
+}
+
+size_t hc_column_store(const hc_column *col, unsigned char *buf)
+{
+	unsigned char *p = buf;
+	size_t b, k;
+
+	memcpy(p, COLUMN_MAGIC, 4);
+	p = put_u64(p + 4, col->rows);
+	p = put_u64(p, col->blocks);
+	for (b = 0; b < col->blocks; b++) {
+		const hc_column_block *blk = &col->index[b];
+		p = put_u64(p, (uint64_t)blk->first);
+		p = put_u64(p, (uint64_t)blk->min_delta);
+		p = put_u64(p, (uint64_t)blk->min);
+		p = put_u64(p, (uint64_t)blk->max);
+		*p++ = (unsigned char)blk->width;
+	}
+	for (k = 0; k < col->words; k++)
+		p = put_u64(p, col->data[k]);
+	return (size_t)(p - buf);
+}
+
+int hc_column_load(hc_column *col, const unsigned char *buf, const size_t len)
+{
+	const unsigned char *p;
+	uint64_t rows, blocks;
+	size_t b, k, words = 0;
+
+	if (col == NULL || buf == NULL || len < STORED_HEADER || memcmp(buf, COLUMN_MAGIC, 4) != 0)
+		return -1;
+	rows = get_u64(buf + 4);
+	blocks = get_u64(buf + 12);
+	/* rounded up without adding, which would wrap for a corrupt count of rows */
+	if (blocks != rows / HC_COLUMN_BLOCK + (rows % HC_COLUMN_BLOCK != 0)
+			|| blocks > (len - STORED_HEADER) / STORED_BLOCK)
+		return -1;
+	/* the length of the data follows from the widths */
+	for (b = 0, p = buf + STORED_HEADER; b < blocks; b++, p += STORED_BLOCK) {
+		const size_t n = b + 1 < blocks ? HC_COLUMN_BLOCK : rows - b * HC_COLUMN_BLOCK;
+		if (p[32] > 63)
+			return -1;
+		words += block_words(n, p[32]);
+	}
+	if (len != STORED_HEADER + STORED_BLOCK * blocks + 8 * words)
+		return -1;
+
+	if (column_alloc(col, rows, words) != 0)
+		return -1;
+	for (b = 0, p = buf + STORED_HEADER; b < blocks; b++, p += STORED_BLOCK) {
+		hc_column_block *blk = &col->index[b];
+		blk->first = (hc_abs_day)get_u64(p);
+		blk->min_delta = (hc_abs_day)get_u64(p + 8);
+		blk->min = (hc_abs_day)get_u64(p + 16);
+		blk->max = (hc_abs_day)get_u64(p + 24);
+		blk->width = p[32];
+		blk->offset = col->words;
+		col->words += block_words(block_rows(col, b), blk->width);
+	}
+	for (k = 0; k < words; k++, p += 8)
+		col->data[k] = get_u64(p);
+	return 0;
+}
+
+int hc_column_decode_abs(const hc_column *col, size_t first_row, hc_abs_day *out, const int count)
+{
+	hc_abs_day buf[HC_COLUMN_BLOCK];
+	int done = 0;
+
+	if (col == NULL || out == NULL || count < 0)
+		return -1;
+	while (done < count && first_row < col->rows) {
+		const size_t b = first_row / HC_COLUMN_BLOCK, skip = first_row % HC_COLUMN_BLOCK;
+		size_t n = block_rows(col, b) - skip;
+		if (n > (size_t)(count - done))
+			n = (size_t)(count - done);
+		if (skip == 0 && n == block_rows(col, b)) {
+			/* a whole block goes straight to the output */
+			decode_block(col, b, out + done);
+		} else {
+			decode_block(col, b, buf);
+			memcpy(out + done, buf + skip, n * sizeof(hc_abs_day));
+		}
+		done += (int)n;
+		first_row += n;
+	}
+	return done;
+}
+
+/* the year of the last date decoded, covering the days [start, end) */
+typedef struct year_cache_s {
+	hc_calendar_type cal;
+	hc_abs_day start;
+	hc_abs_day end;
+	int year;
+	int leap;
+	heb_year_layout heb;
+} year_cache;
+
+static void cache_init(year_cache *c, const hc_calendar_type cal)
+{
+	c->cal = cal;
+	c->start = c->end = 0;
+}
+
+/* date of a day, through the cached year when it holds the day */
+static int cached_date(year_cache *c, const hc_abs_day abs_date, hc_date *out)
+{
+	int i;
+
+	if (abs_date < c->start || abs_date >= c->end) {
+		switch (c->cal) {
+		case GREGORIAN:
+			if (hc_greg_compute_date(abs_date, out) != 0)
+				return -1;
+			c->year = out->year;
+			c->leap = hc_greg_is_leap_year(out->year);
+			c->start = hc_greg_to_abs_date(out->year, 1, 1);
+			c->end = c->start + 365 + c->leap;
+			return 0;
+		case JULIAN:
+			if (hc_jul_compute_date(abs_date, out) != 0)
+				return -1;
+			c->year = out->year;
+			c->leap = hc_jul_is_leap_year(out->year);
+			c->start = hc_jul_to_abs_date(out->year, 1, 1);
+			c->end = c->start + 365 + c->leap;
+			return 0;
+		case HEBREW:
+			/* sorted days mostly move on to the next year */
+			if (abs_date == c->end && c->end != 0)
+				heb_year_layout_next(&c->heb);
+			else if (heb_year_layout_find(&c->heb, abs_date) < 0)
+				return -1;
+			c->start = c->heb.rosh_hashana;
+			c->end = c->heb.next_rosh_hashana;
+			break;
+		default:
+			return hc_set_abs_date(out, abs_date, c->cal);
+		}
+	}
+
+	if (c->cal == HEBREW) {
+		for (i = c->heb.months - 1; c->heb.month_start[i] > abs_date; i--)
+			;
+		out->year = c->heb.year;
+		out->month = c->heb.month[i];
+		out->day = (int)(abs_date - c->heb.month_start[i]) + 1;
+	} else {
+		out->year = c->year;
+		hc_common_day_of_year(c->leap, (int)(abs_date - c->start), out);
+	}
+	out->calendar_type = c->cal;
+	return 0;
+}
+
+int hc_column_decode(const hc_column *col, size_t first_row, const hc_calendar_type cal,
+		hc_date *out, const int count)
+{
+	hc_abs_day buf[HC_COLUMN_BLOCK];
+	year_cache cache;
+	int done = 0;
+
+	if (col == NULL || out == NULL || count < 0 || get_calendar(cal) == NULL)
+		return -1;
+	cache_init(&cache, cal);
+	while (done < count && first_row < col->rows) {
+		const size_t b = first_row / HC_COLUMN_BLOCK;
+		size_t i = first_row % HC_COLUMN_BLOCK;
+		const size_t n = block_rows(col, b);
+
+		decode_block(col, b, buf);
+		for (; i < n && done < count; i++, done++, first_row++) {
+			if (cached_date(&cache, buf[i], &out[done]) != 0)
+				return -1;
+		}
+	}
+	return done;
+}
+
+int hc_column_scan(const hc_column *col, const hc_abs_day from_abs, const hc_abs_day to_abs, size_t start_row,
+		size_t *rows, const hc_calendar_type cal, hc_date *dates, const int max_out)
+{
+	hc_abs_day buf[HC_COLUMN_BLOCK];
+	year_cache cache;
+	size_t b;
+	int found = 0;
+
+	if (col == NULL || max_out < 0 || (dates != NULL && get_calendar(cal) == NULL))
+		return -1;
+	cache_init(&cache, cal);
+	for (b = start_row / HC_COLUMN_BLOCK; b < col->blocks && found < max_out; b++) {
+		const hc_column_block *blk = &col->index[b];
+		const size_t n = block_rows(col, b);
+		size_t i = b == start_row / HC_COLUMN_BLOCK ? start_row % HC_COLUMN_BLOCK : 0;
+
+		if (blk->max < from_abs || blk->min > to_abs)
+			continue;
+		decode_block(col, b, buf);
+		for (; i < n && found < max_out; i++) {
+			if (buf[i] < from_abs || buf[i] > to_abs)
+				continue;
+			if (dates != NULL && cached_date(&cache, buf[i], &dates[found]) != 0)
+				return -1;
+			if (rows != NULL)
+				rows[found] = b * HC_COLUMN_BLOCK + i;
+			found++;
+		}
+	}
+	return found;
+}
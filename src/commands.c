@@ -0,0 +1,255 @@
+/**
+ Interpreter of the hconverter command language, shared by the command line
+ tool and the load generator.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "hconverter.h"
+#include "hc_internal.h"
+
+/** Commands and their aliases; the first name of each is the canonical one */
+static const char *const COMMANDS[][4] = {
+	{"quit", "exit", "q", NULL},
+	{"isleap", "is_leap", NULL, NULL},
+	{"type", "t", NULL, NULL},
+	{"keviut", "k", "kevius", NULL},
+	{"molad", "m", NULL, NULL},
+	{"convert", "c", NULL, NULL},
+	{"format", "f", NULL, NULL},
+	{"absolute", "a", "abs", NULL},
+	{"cache", NULL, NULL, NULL},
+};
+
+void cmd_tokenize(char *cmd, char **tokens)
+{
+	char *save = NULL;
+	int j;
+
+	for (char* p = cmd; *p; p++) {
+		*p = tolower(*p);
+		if (*p == '\n')
+			*p = '\0';
+	}
+
+	tokens[0] = strtok_r(cmd, " .-", &save);
+	for (j = 1; j < CMD_TOKENS; j++) {
+		tokens[j] = strtok_r(NULL, " .-", &save);
+	}
+}
+
+const char *cmd_name(const char *token)
+{
+	size_t i, j;
+
+	if (token == NULL)
+		return NULL;
+	for (i = 0; i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); i++)
+		for (j = 0; j < 4 && COMMANDS[i][j] != NULL; j++)
+			if (strcmp(token, COMMANDS[i][j]) == 0)
+				return COMMANDS[i][0];
+	return NULL;
+}
+
+static hc_calendar_type parse_cal_type(char *str) {
+	if (strcmp(str, "hebrew") == 0 || strcmp(str, "h") == 0)
+		return HEBREW;
+	if (strcmp(str, "gregorian") == 0 || strcmp(str, "g") == 0)
+		return GREGORIAN;
+	if (strcmp(str, "julian") == 0 || strcmp(str, "j") == 0)
+		return JULIAN;
+	if (strcmp(str, "islamic") == 0 || strcmp(str, "i") == 0)
+		return ISLAMIC;
+	if (strcmp(str, "isoweek") == 0 || strcmp(str, "w") == 0)
+		return ISO_WEEK;
+
+	return NONE;
+}
+
+static char* dow_string(const int dow)
+{
+	switch(dow) {
+	case SATURDAY: return "SATURDAY";
+	case SUNDAY: return "SUNDAY";
+	case MONDAY: return "MONDAY";
+	case TUESDAY: return "TUESDAY";
+	case WEDNESDAY: return "WEDNESDAY";
+	case THURSDAY: return "THURSDAY";
+	case FRIDAY: return "FRIDAY";
+	default: return "NULL";
+	}
+}
+
+static char* heb_type_string(const int t)
+{
+	switch(t) {
+	case SHORT_HEB_YEAR: return "SHORT";
+	case FULL_HEB_YEAR: return "FULL";
+	case NORMAL_HEB_YEAR: return "REGULAR";
+	default: return "NULL";
+	}
+}
+
+int run_cmd(char** cmd_tokenized, FILE *out)
+{
+	hc_calendar_type convert_from, convert_to;
+	const char *cmd = cmd_name(cmd_tokenized[0]);
+	int year, month, day;
+	hc_date d;
+	heb_time t;
+
+
+	if (cmd == NULL)
+		return -1;
+	if (strcmp(cmd, "quit") == 0)
+		return 1;
+
+	if (strcmp(cmd, "isleap") == 0) {
+		hc_cal_impl* cal;
+		if (cmd_tokenized[1] == NULL)
+			convert_to = HEBREW;
+		else
+			convert_to = parse_cal_type(cmd_tokenized[1]);
+		if (convert_to == NONE)
+			return -1;
+
+		if (cmd_tokenized[2] == NULL)
+			return -1;
+		year = strtol(cmd_tokenized[2], NULL, 0);
+		if ((cal = get_calendar(convert_to)) == NULL)
+			return -1;
+		fprintf(out, "%d", cal->is_leap_year(year));
+		return 0;
+	}
+
+	if (strcmp(cmd, "type") == 0) {
+		if (cmd_tokenized[1] == NULL)
+			return -1;
+		year = strtol(cmd_tokenized[1], NULL, 0);
+		fprintf(out, "%d", hc_get_heb_year_type(year));
+		return 0;
+	}
+
+	if (strcmp(cmd, "keviut") == 0) {
+		int leap, rh, pesach, ck;
+		if (cmd_tokenized[1] == NULL)
+			return -1;
+		year = strtol(cmd_tokenized[1], NULL, 0);
+		if (hc_compute_keviut(year, &rh, &pesach, &ck, &leap) != 0) {
+			fprintf(out, "Invalid year");
+			return -1;
+		}
+		fprintf(out, "Rosh Hashana %s, Pesach %s, Cheshvan/Kislev %s, leap %s",
+			dow_string(rh), dow_string(pesach), heb_type_string(ck), leap ? "YES" : "NO");
+		return 0;
+	}
+
+	if (strcmp(cmd, "molad") == 0) {
+		if (cmd_tokenized[1] == NULL)
+			convert_to = GREGORIAN;
+		else
+			convert_to = parse_cal_type(cmd_tokenized[1]);
+		if (convert_to == NONE)
+			return -1;
+
+		if (cmd_tokenized[2] == NULL)
+			return -1;
+		year = strtol(cmd_tokenized[2], NULL, 0);
+		if (cmd_tokenized[3] == NULL)
+			month = 7;
+		else
+			month = strtol(cmd_tokenized[3], NULL, 0);
+		if (hc_compute_molad(year, month, convert_to, &d, &t) != 0) {
+			fprintf(out, "Invalid date");
+			return -1;
+		}
+		fprintf(out, "%4d-%02d-%02d %02d:%04d", d.year, d.month, d.day, t.hour, t.part);
+		return 0;
+	}
+
+	if (strcmp(cmd, "convert") == 0) {
+		if (cmd_tokenized[1] == NULL || (convert_from = parse_cal_type(cmd_tokenized[1])) == NONE)
+			return -1;
+
+		if (cmd_tokenized[2] == NULL || (convert_to = parse_cal_type(cmd_tokenized[2])) == NONE)
+			return -1;
+
+		if (cmd_tokenized[3] == NULL || (year = strtol(cmd_tokenized[3], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[4] == NULL || (month = strtol(cmd_tokenized[4], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[5] == NULL || (day = strtol(cmd_tokenized[5], NULL, 0)) < 1)
+		 	return -1;
+		d.calendar_type = convert_from;
+		d.day = day;
+		d.year = year;
+		d.month = month;
+		if (!hc_check(&d)) {
+			fprintf(out, "Invalid date");
+			return -1;
+		}
+		hc_convert(&d, convert_to);
+		fprintf(out, "%4d-%02d-%02d", d.year, d.month, d.day);
+		return 0;
+	}
+
+	if (strcmp(cmd, "format") == 0) {
+		char buf[64];
+		if (cmd_tokenized[1] == NULL || (convert_from = parse_cal_type(cmd_tokenized[1])) == NONE)
+			return -1;
+
+		if (cmd_tokenized[2] == NULL || (year = strtol(cmd_tokenized[2], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[3] == NULL || (month = strtol(cmd_tokenized[3], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[4] == NULL || (day = strtol(cmd_tokenized[4], NULL, 0)) < 1)
+		 	return -1;
+		set_hc_date(&d, year, month, day, convert_from);
+		if (hc_format_hebrew(&d, FORMAT_HEBREW_LETTERS, buf, sizeof(buf)) < 0) {
+			fprintf(out, "Invalid date");
+			return -1;
+		}
+		fprintf(out, "%s, ", buf);
+		hc_format_hebrew(&d, FORMAT_TRANSLITERATED, buf, sizeof(buf));
+		fprintf(out, "%s", buf);
+		return 0;
+	}
+
+	if (strcmp(cmd, "absolute") == 0) {
+		hc_abs_day a;
+		if (cmd_tokenized[1] == NULL || (convert_from = parse_cal_type(cmd_tokenized[1])) == NONE)
+			return -1;
+
+		if (cmd_tokenized[2] == NULL || (year = strtol(cmd_tokenized[2], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[3] == NULL || (month = strtol(cmd_tokenized[3], NULL, 0)) < 1)
+		 	return -1;
+		if (cmd_tokenized[4] == NULL || (day = strtol(cmd_tokenized[4], NULL, 0)) < 1)
+		 	return -1;
+		if ((a = hc_get_abs_date(&(hc_date){convert_from, year, month, day})) < 1)
+			return -1;
+		fprintf(out, "Absolute day: %lld", (long long)a);
+		return 0;
+	}
+
+	if (strcmp(cmd, "cache") == 0) {
+		hc_cache_stats stats;
+		if (cmd_tokenized[1] != NULL && strcmp(cmd_tokenized[1], "on") == 0)
+			hc_cache_enable(1);
+		else if (cmd_tokenized[1] != NULL && strcmp(cmd_tokenized[1], "off") == 0)
+			hc_cache_enable(0);
+		else if (cmd_tokenized[1] != NULL && strcmp(cmd_tokenized[1], "clear") == 0)
+			hc_cache_clear();
+		else if (cmd_tokenized[1] != NULL)
+			return -1;
+		hc_cache_get_stats(&stats);
+		fprintf(out, "Cache %s, %lu lookups, %lu hits (%.1f%%), %lu evictions",
+			hc_cache_is_enabled() ? "on" : "off", stats.lookups, stats.hits,
+			stats.lookups ? 100.0 * stats.hits / stats.lookups : 0.0, stats.evictions);
+		return 0;
+	}
+
+	return -1;
+}
+
@@ -2,9 +2,22 @@
  Some definitions common to Julian and Gregorian implementations
  */
 
-/** Days since creation to start of Gregorian and Julian calendars */
-const long COMMON_BEGINNING = 1373429;
+#include "hconverter.h"
+
+/** Days since creation to start of Gregorian calendar */
+const hc_abs_day HC_COMMON_BEGINNING = 1373429;
+
+/** Days since creation to start of Julian calendar; 1 Jan 1 (Julian) is
+    two days before 1 Jan 1 (Gregorian) */
+const hc_abs_day HC_JULIAN_BEGINNING = 1373427;
 
 /** Standard month lengths for Gregorian and Julian calendars */
-const int COMMON_MONTH_LENGTH[12] =
+const int HC_COMMON_MONTH_LENGTH[12] =
 	{ 31, -1, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/** Days before each month of a common year, and in the whole year */
+const int HC_COMMON_DAYS_BEFORE_MONTH[13] =
+	{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 };
+
+/** Julian day number (noon) minus absolute day, for astronomical computations */
+const hc_abs_day ABS_TO_JULIAN_DAY = 347996;
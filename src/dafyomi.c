@@ -0,0 +1,152 @@
+/**
+ Daf Yomi: the cycle of learning one page (daf) of the Babylonian Talmud a day.
+
+ The first cycle began on 11 September 1923. Up to the 7th cycle, Shekalim
+ was learned in 12 pages and a cycle took 2702 days; from the 8th, which
+ began on 24 June 1975, it has 21 pages and a cycle takes 2711 days.
+
+ The day of the cycle is found from the absolute day with a division, and the
+ tractate from a static table of cumulative page counts.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stddef.h>
+
+/** Absolute day of 11 September 1923, start of the 1st cycle */
+#define FIRST_CYCLE_START 2075678L
+/** Absolute day of 24 June 1975, start of the 8th cycle */
+#define EIGHTH_CYCLE_START 2094592L
+
+#define OLD_CYCLE_LENGTH 2702
+#define CYCLE_LENGTH 2711
+#define NUM_TRACTATES 40
+
+/** Index of Shekalim, the tractate whose length changed */
+#define SHEKALIM 4
+
+static const char *const TRACTATE_NAMES[NUM_TRACTATES] = {
+	"Berachot", "Shabbat", "Eruvin", "Pesachim", "Shekalim", "Yoma", "Sukkah",
+	"Beitzah", "Rosh Hashana", "Taanit", "Megillah", "Moed Katan", "Chagigah",
+	"Yevamot", "Ketubot", "Nedarim", "Nazir", "Sotah", "Gittin", "Kiddushin",
+	"Bava Kamma", "Bava Metzia", "Bava Batra", "Sanhedrin", "Makkot", "Shevuot",
+	"Avodah Zarah", "Horayot", "Zevachim", "Menachot", "Chullin", "Bechorot",
+	"Arachin", "Temurah", "Keritot", "Meilah", "Kinnim", "Tamid", "Middot", "Niddah"
+};
+
+/** First page learned of each tractate; all but the small ones that follow Meilah start at 2 */
+static const unsigned char FIRST_PAGE[NUM_TRACTATES] = {
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 23, 26, 34, 2
+};
+
+/** Days of the cycle learned up to the end of each tractate, from the 8th cycle on */
+static const short CUMULATIVE[NUM_TRACTATES] = {
+	63, 219, 323, 443, 464, 551, 606, 645, 679, 709, 740, 768, 794, 915,
+	1026, 1116, 1181, 1229, 1318, 1399, 1517, 1635, 1810, 1922, 1945, 1993,
+	2068, 2081, 2200, 2309, 2450, 2510, 2543, 2576, 2603, 2624, 2627, 2635,
+	2639, 2711
+};
+
+/** The same for cycles 1-7, with the shorter Shekalim */
+static const short OLD_CUMULATIVE[NUM_TRACTATES] = {
+	63, 219, 323, 443, 455, 542, 597, 636, 670, 700, 731, 759, 785, 906,
+	1017, 1107, 1172, 1220, 1309, 1390, 1508, 1626, 1801, 1913, 1936, 1984,
+	2059, 2072, 2191, 2300, 2441, 2501, 2534, 2567, 2594, 2615, 2618, 2626,
+	2630, 2702
+};
+
+/* find cycle and day within the cycle (0-based) of an absolute day */
+static int cycle_of(const hc_abs_day abs_date, hc_abs_day *day)
+{
+	if (abs_date < FIRST_CYCLE_START)
+		return -1;
+	if (abs_date < EIGHTH_CYCLE_START) {
+		*day = (abs_date - FIRST_CYCLE_START) % OLD_CYCLE_LENGTH;
+		return 1 + (int)((abs_date - FIRST_CYCLE_START) / OLD_CYCLE_LENGTH);
+	}
+	*day = (abs_date - EIGHTH_CYCLE_START) % CYCLE_LENGTH;
+	return 8 + (int)((abs_date - EIGHTH_CYCLE_START) / CYCLE_LENGTH);
+}
+
+static void daf_of(const int cycle, const hc_abs_day day, hc_daf *daf)
+{
+	const short *cumulative = cycle < 8 ? OLD_CUMULATIVE : CUMULATIVE;
+	int lo = 0, hi = NUM_TRACTATES - 1;
+
+	/* first tractate whose cumulative count exceeds the day; a fixed 6 steps */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (cumulative[mid] > day)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	daf->cycle = cycle;
+	daf->tractate = lo;
+	daf->page = FIRST_PAGE[lo] + (int)(day - (lo ? cumulative[lo - 1] : 0));
+}
+
+/* number of pages learned of a tractate in given cycle */
+static int tractate_pages(const int cycle, const int tractate)
+{
+	if (tractate == SHEKALIM)
+		return cycle < 8 ? 12 : 21;
+	return CUMULATIVE[tractate] - (tractate ? CUMULATIVE[tractate - 1] : 0);
+}
+
+const char *hc_tractate_name(const int tractate)
+{
+	if (tractate < 0 || tractate >= NUM_TRACTATES)
+		return NULL;
+	return TRACTATE_NAMES[tractate];
+}
+
+hc_abs_day hc_daf_yomi_cycle_start(const int cycle)
+{
+	if (cycle < 1)
+		return -1;
+	if (cycle < 8)
+		return FIRST_CYCLE_START + (hc_abs_day)(cycle - 1) * OLD_CYCLE_LENGTH;
+	return EIGHTH_CYCLE_START + (hc_abs_day)(cycle - 8) * CYCLE_LENGTH;
+}
+
+int hc_daf_yomi(const hc_abs_day abs_date, hc_daf *daf)
+{
+	hc_abs_day day;
+	const int cycle = cycle_of(abs_date, &day);
+
+	if (cycle < 0)
+		return -1;
+	daf_of(cycle, day, daf);
+	return 0;
+}
+
+int hc_daf_yomi_range(const hc_abs_day from_abs, const hc_abs_day to_abs, hc_daf *out)
+{
+	hc_daf daf;
+	hc_abs_day a, next_cycle;
+	int last_page;
+
+	if (out == NULL || to_abs < from_abs || hc_daf_yomi(from_abs, &daf) != 0)
+		return -1;
+
+	/* look up the first day, then just turn pages */
+	last_page = FIRST_PAGE[daf.tractate] + tractate_pages(daf.cycle, daf.tractate) - 1;
+	next_cycle = hc_daf_yomi_cycle_start(daf.cycle + 1);
+	for (a = from_abs; a <= to_abs; a++) {
+		if (a == next_cycle) {
+			daf.cycle++;
+			next_cycle = hc_daf_yomi_cycle_start(daf.cycle + 1);
+			daf.tractate = 0;
+			daf.page = FIRST_PAGE[0];
+			last_page = FIRST_PAGE[0] + tractate_pages(daf.cycle, 0) - 1;
+		}
+		out[a - from_abs] = daf;
+		if (++daf.page > last_page && daf.tractate + 1 < NUM_TRACTATES) {
+			daf.tractate++;
+			daf.page = FIRST_PAGE[daf.tractate];
+			last_page = daf.page + tractate_pages(daf.cycle, daf.tractate) - 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ Formatting of Hebrew dates: in Hebrew letters (gematria), as in
+ "ט״ו בניסן תשפ״ד", or with transliterated month names, as in "15 Nisan 5784".
+
+ All strings are precomputed UTF-8 and copied into the caller's buffer;
+ nothing is allocated.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdio.h>
+#include <string.h>
+
+/** Days of the month 1-30 in letters, punctuated */
+static const char *const DAY_LETTERS[31] = { "",
+	"א׳", "ב׳", "ג׳", "ד׳", "ה׳", "ו׳", "ז׳", "ח׳", "ט׳", "י׳",
+	"י״א", "י״ב", "י״ג", "י״ד", "ט״ו", "ט״ז", "י״ז", "י״ח", "י״ט", "כ׳",
+	"כ״א", "כ״ב", "כ״ג", "כ״ד", "כ״ה", "כ״ו", "כ״ז", "כ״ח", "כ״ט", "ל׳"
+};
+
+/* Letters of the year, without punctuation, composed as hundreds + tens + units */
+static const char *const HUNDREDS[10] = {
+	"", "ק", "ר", "ש", "ת", "תק", "תר", "תש", "תת", "תתק"
+};
+static const char *const TENS[10] = {
+	"", "י", "כ", "ל", "מ", "נ", "ס", "ע", "פ", "צ"
+};
+static const char *const UNITS[10] = {
+	"", "א", "ב", "ג", "ד", "ה", "ו", "ז", "ח", "ט"
+};
+
+static const char GERESH[] = "׳";
+static const char GERSHAYIM[] = "״";
+
+/** Hebrew month names by month number, with the prefix "ב" (of) */
+static const char *const MONTH_LETTERS[14] = { "",
+	"בניסן", "באייר", "בסיון", "בתמוז", "באב", "באלול",
+	"בתשרי", "בחשון", "בכסלו", "בטבת", "בשבט", "באדר", "באדר ב׳"
+};
+
+static const char *const MONTH_NAMES[14] = { "",
+	"Nisan", "Iyar", "Sivan", "Tamuz", "Av", "Elul",
+	"Tishrei", "Cheshvan", "Kislev", "Teveth", "Shvat", "Adar", "Adar II"
+};
+
+/* Adar of a leap year is Adar I */
+static const char LEAP_ADAR_LETTERS[] = "באדר א׳";
+static const char LEAP_ADAR_NAME[] = "Adar I";
+
+const char *heb_month_name(const int month, const int leap)
+{
+	if (month < 1 || month > 13)
+		return NULL;
+	return leap && month == 12 ? LEAP_ADAR_NAME : MONTH_NAMES[month];
+}
+
+/* Append a string to the buffer; returns -1 once it no longer fits */
+static int append(char *buf, const size_t size, size_t *pos, const char *str)
+{
+	const size_t len = strlen(str);
+	if (*pos + len >= size)
+		return -1;
+	memcpy(buf + *pos, str, len + 1);
+	*pos += len;
+	return 0;
+}
+
+/* Year below 1000 in letters, punctuated: gershayim before the last letter,
+   or geresh after a single letter. Every letter is 2 bytes in UTF-8. -1 for
+   a larger year, which has no letters of its own. */
+static int year_letters(int year, char *out, const size_t size)
+{
+	char letters[16];
+	const int tens_units = year % 100;
+	size_t len;
+
+	if (year >= 1000)
+		return -1;
+	strcpy(letters, HUNDREDS[year / 100 % 10]);
+	/* 15 and 16 are written 9+6 and 9+7, not to spell the Name */
+	if (tens_units == 15 || tens_units == 16) {
+		strcat(letters, UNITS[9]);
+		strcat(letters, UNITS[tens_units - 9]);
+	} else {
+		strcat(letters, TENS[tens_units / 10]);
+		strcat(letters, UNITS[tens_units % 10]);
+	}
+	len = strlen(letters);
+	if (len + sizeof(GERSHAYIM) > size)
+		return -1;
+	if (len == 0) {
+		out[0] = '\0';
+	} else if (len == 2) {
+		memcpy(out, letters, 2);
+		memcpy(out + 2, GERESH, sizeof(GERESH));
+	} else {
+		memcpy(out, letters, len - 2);
+		memcpy(out + len - 2, GERSHAYIM, sizeof(GERSHAYIM) - 1);
+		memcpy(out + len - 2 + sizeof(GERSHAYIM) - 1, letters + len - 2, 2);
+		out[len + sizeof(GERSHAYIM) - 1] = '\0';
+	}
+	return 0;
+}
+
+int hc_format_hebrew(const hc_date *date, const int flags, char *buf, const size_t size)
+{
+	hc_date d = *date;
+	size_t pos = 0;
+	int leap;
+	char num[24];
+
+	if (buf == NULL || size == 0)
+		return -1;
+	buf[0] = '\0';
+	if (d.calendar_type != HEBREW && hc_convert(&d, HEBREW) != 0)
+		return -1;
+	if (!hc_check(&d))
+		return -1;
+	leap = hc_heb_is_leap_year(d.year);
+
+	if (flags & FORMAT_TRANSLITERATED) {
+		snprintf(num, sizeof(num), "%d ", d.day);
+		if (append(buf, size, &pos, num) != 0
+				|| append(buf, size, &pos, heb_month_name(d.month, leap)) != 0)
+			return -1;
+		if (!(flags & FORMAT_NO_YEAR)) {
+			snprintf(num, sizeof(num), " %d", d.year);
+			if (append(buf, size, &pos, num) != 0)
+				return -1;
+		}
+		return (int)pos;
+	}
+
+	if (append(buf, size, &pos, DAY_LETTERS[d.day]) != 0
+			|| append(buf, size, &pos, " ") != 0
+			|| append(buf, size, &pos, leap && d.month == 12 ? LEAP_ADAR_LETTERS : MONTH_LETTERS[d.month]) != 0)
+		return -1;
+	if (!(flags & FORMAT_NO_YEAR)) {
+		if (append(buf, size, &pos, " ") != 0)
+			return -1;
+		/* a round thousand has no other letters, so it is written even without FORMAT_THOUSANDS */
+		if (((flags & FORMAT_THOUSANDS) && d.year >= 1000) || d.year % 1000 == 0) {
+			if (year_letters(d.year / 1000, num, sizeof(num)) != 0 || append(buf, size, &pos, num) != 0)
+				return -1;
+		}
+		if (year_letters(d.year % 1000, num, sizeof(num)) != 0 || append(buf, size, &pos, num) != 0)
+			return -1;
+	}
+	return (int)pos;
+}
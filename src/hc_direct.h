@@ -0,0 +1,265 @@
+/*!
+  \brief Direct conversion entry points for fixed pairs of calendars.
+===================================================
+
+  \file hc_direct.h
+
+  The generic functions of hconverter.h pick the calendar implementation
+  at run time and call it through function pointers. When both calendars of
+  a conversion are known in advance, the functions here may be used instead.
+  They are static inline and call the calendar arithmetic directly, so the
+  Gregorian and Julian computations are inlined into the caller and a loop
+  of conversions contains no indirect branches.
+
+  Each function takes and modifies an ::hc_date just like #hc_convert, and
+  returns 0 on success, -1 if the input date is invalid. The calendar type of
+  the input is not looked at; it is implied by the function name.
+
+  The calendar arithmetic the entry points are built from is in this header
+  too, and like everything else the library exports it is prefixed hc_ (or
+  HC_ for constants).
+ */
+#ifndef SRC_HC_DIRECT_H_
+#define SRC_HC_DIRECT_H_
+#include "hconverter.h"
+
+/** Days since creation to start of Gregorian calendar */
+extern const hc_abs_day HC_COMMON_BEGINNING;
+
+/** Days since creation to start of Julian calendar */
+extern const hc_abs_day HC_JULIAN_BEGINNING;
+
+/** Years whose dates all fall within HC_MAX_ABS_DATE, in every calendar: none
+    has years of more than 385 days, nor starts after day 2000000. The dates of
+    later years are checked against HC_MAX_ABS_DATE one by one. */
+#define HC_MAX_FULL_YEAR ((int)((HC_MAX_ABS_DATE - 2000000) / 385))
+
+/** Standard month lengths for Gregorian and Julian calendars */
+extern const int HC_COMMON_MONTH_LENGTH[12];
+
+/** Days before each month of a common year, and in the whole year */
+extern const int HC_COMMON_DAYS_BEFORE_MONTH[13];
+
+/* Hebrew calendar arithmetic, in hebrew.c */
+int hc_heb_is_leap_year(int year);
+int hc_heb_check_date(int year, int month, int day);
+hc_abs_day hc_heb_to_abs_date(int year, int month, int day);
+int hc_heb_compute_date(hc_abs_day abs_date, hc_date *target);
+
+/* Month and day of a (0-based) day of the year; a year has 31 days at most
+   more than its months' starting days, so the month is found in one step */
+static inline void hc_common_day_of_year(const int leap, const int doy, hc_date *target)
+{
+	int mh = doy / 31 + 1;
+
+	if (mh < 12 && doy >= HC_COMMON_DAYS_BEFORE_MONTH[mh] + (leap && mh >= 2))
+		mh++;
+	target->month = mh;
+	target->day = doy - HC_COMMON_DAYS_BEFORE_MONTH[mh - 1] - (leap && mh > 2) + 1;
+}
+
+/* Gregorian calendar arithmetic */
+
+static inline int hc_greg_is_leap_year(const int year)
+{
+    if (year % 4 != 0)
+        return 0;
+    if (year % 100 != 0)
+        return 1;
+    return year % 400 == 0;
+}
+
+static inline int hc_greg_month_length(const int year, const int month)
+{
+    if (month < 1 || month > 12)
+        return -1;
+    if (month == 2)
+    	return hc_greg_is_leap_year(year) ? 29 : 28;
+    else
+        return HC_COMMON_MONTH_LENGTH[month-1];
+}
+
+static inline hc_abs_day hc_greg_to_abs_date(const int year, const int month, const int day)
+{
+	hc_abs_day ret = HC_COMMON_BEGINNING;
+	const hc_abs_day passed_years = year-1;
+
+	if (month < 1 || month > 12)
+		return -1;
+	ret += 365 * passed_years;
+	ret += passed_years/4;
+	ret -= passed_years/100;
+	ret += passed_years/400;
+
+	ret += HC_COMMON_DAYS_BEFORE_MONTH[month-1] + (month > 2 && hc_greg_is_leap_year(year));
+	ret += day;
+	return ret;
+}
+
+static inline int hc_greg_check_date(const int year, const int month, const int day)
+{
+    if (year < 1 || year > HC_MAX_YEAR || month < 1 || month > 12)
+        return 0;
+    if (day < 1 || (day > 28 && (day > hc_greg_month_length(year, month))))
+        return 0;
+    if (year > HC_MAX_FULL_YEAR && hc_greg_to_abs_date(year, month, day) > HC_MAX_ABS_DATE)
+        return 0;
+    return 1;
+}
+
+static inline int hc_greg_compute_date(const hc_abs_day abs_date, hc_date *target)
+{
+	/* days since 1 January 1 */
+	hc_abs_day d = abs_date - HC_COMMON_BEGINNING - 1;
+	hc_abs_day n400, n100, n4, n1;
+	int yr;
+
+	// error - calendar does not exist yet, or out of range
+	if (d < 0 || abs_date > HC_MAX_ABS_DATE)
+		return -1;
+
+	/* whole cycles of 400, 100 and 4 years, and whole years, before the day */
+	n400 = d / 146097;
+	d %= 146097;
+	n100 = d / 36524;
+	d %= 36524;
+	n4 = d / 1461;
+	d %= 1461;
+	n1 = d / 365;
+	d %= 365;
+	yr = (int)(400 * n400 + 100 * n100 + 4 * n4 + n1);
+
+	if (n100 == 4 || n1 == 4) {
+		/* last day of a leap year ending a cycle */
+		target->year = yr;
+		target->month = 12;
+		target->day = 31;
+	} else {
+		target->year = yr + 1;
+		hc_common_day_of_year(hc_greg_is_leap_year(yr + 1), (int)d, target);
+	}
+    target->calendar_type = GREGORIAN;
+	return 0;
+}
+
+/* Julian calendar arithmetic */
+
+static inline int hc_jul_month_length(const int year, const int month)
+{
+    if (month < 1 || month > 12)
+        return -1;
+    if (month == 2)
+		return year % 4 == 0 ? 29 : 28;
+    else
+        return HC_COMMON_MONTH_LENGTH[month-1];
+}
+
+static inline int hc_jul_is_leap_year(const int year)
+{
+    return (year % 4 == 0) ? 1 : 0;
+}
+
+static inline hc_abs_day hc_jul_to_abs_date(const int year, const int month, const int day)
+{
+	hc_abs_day ret = HC_JULIAN_BEGINNING;
+	const hc_abs_day passed_years = year-1;
+
+	if (month < 1 || month > 12)
+		return -1;
+	ret += 365 * passed_years;
+	ret += passed_years/4;
+
+	ret += HC_COMMON_DAYS_BEFORE_MONTH[month-1] + (month > 2 && hc_jul_is_leap_year(year));
+	ret += day;
+	return ret;
+}
+
+static inline int hc_jul_check_date(const int year, const int month, const int day)
+{
+    if (year < 1 || year > HC_MAX_YEAR || month < 1 || month > 12)
+        return 0;
+    if (day < 1 || (day > 28 && (day > hc_jul_month_length(year, month))))
+        return 0;
+    if (year > HC_MAX_FULL_YEAR && hc_jul_to_abs_date(year, month, day) > HC_MAX_ABS_DATE)
+        return 0;
+    return 1;
+}
+
+static inline int hc_jul_compute_date(const hc_abs_day abs_date, hc_date *target)
+{
+	/* days since 1 January 1 */
+	hc_abs_day d = abs_date - HC_JULIAN_BEGINNING - 1;
+	hc_abs_day n4, n1;
+
+	// error - calendar does not exist yet, or out of range
+	if (d < 0 || abs_date > HC_MAX_ABS_DATE)
+		return -1;
+
+	/* whole cycles of 4 years, and whole years, before the day */
+	n4 = d / 1461;
+	d %= 1461;
+	n1 = d / 365;
+	if (n1 == 4)
+		n1 = 3; /* last day of the leap year */
+	d -= 365 * n1;
+
+    target->year = (int)(4 * n4 + n1 + 1);
+	hc_common_day_of_year(hc_jul_is_leap_year(target->year), (int)d, target);
+    target->calendar_type = JULIAN;
+	return 0;
+}
+
+/*
+ Generates a direct conversion function from one calendar to another, out of
+ the arithmetic functions of both calendars named with their prefix.
+ */
+#define HC_DIRECT_CONVERSION(name, from, to) \
+static inline int name(hc_date *date) \
+{ \
+	hc_abs_day abs_date; \
+	if (!from##_check_date(date->year, date->month, date->day)) \
+		return -1; \
+	abs_date = from##_to_abs_date(date->year, date->month, date->day); \
+	if (abs_date < 0) return -1; \
+	return to##_compute_date(abs_date, date); \
+}
+
+/*
+ Generates a direct day of week function for one calendar.
+ */
+#define HC_DIRECT_DAY_OF_WEEK(name, cal) \
+static inline hc_day_of_week name(const hc_date *date) \
+{ \
+	return (hc_day_of_week)((cal##_to_abs_date(date->year, date->month, date->day)-1)%7); \
+}
+
+/*! \fn int hc_greg_to_heb(hc_date *date)
+    \brief Convert a Gregorian date to Hebrew, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_greg_to_heb, hc_greg, hc_heb)
+/*! \fn int hc_greg_to_jul(hc_date *date)
+    \brief Convert a Gregorian date to Julian, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_greg_to_jul, hc_greg, hc_jul)
+/*! \fn int hc_heb_to_greg(hc_date *date)
+    \brief Convert a Hebrew date to Gregorian, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_heb_to_greg, hc_heb, hc_greg)
+/*! \fn int hc_heb_to_jul(hc_date *date)
+    \brief Convert a Hebrew date to Julian, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_heb_to_jul, hc_heb, hc_jul)
+/*! \fn int hc_jul_to_greg(hc_date *date)
+    \brief Convert a Julian date to Gregorian, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_jul_to_greg, hc_jul, hc_greg)
+/*! \fn int hc_jul_to_heb(hc_date *date)
+    \brief Convert a Julian date to Hebrew, see #hc_convert */
+HC_DIRECT_CONVERSION(hc_jul_to_heb, hc_jul, hc_heb)
+
+/*! \fn hc_day_of_week hc_greg_day_of_week(const hc_date *date)
+    \brief Day of week of a Gregorian date, see #hc_get_day_of_week */
+HC_DIRECT_DAY_OF_WEEK(hc_greg_day_of_week, hc_greg)
+/*! \fn hc_day_of_week hc_jul_day_of_week(const hc_date *date)
+    \brief Day of week of a Julian date, see #hc_get_day_of_week */
+HC_DIRECT_DAY_OF_WEEK(hc_jul_day_of_week, hc_jul)
+/*! \fn hc_day_of_week hc_heb_day_of_week(const hc_date *date)
+    \brief Day of week of a Hebrew date, see #hc_get_day_of_week */
+HC_DIRECT_DAY_OF_WEEK(hc_heb_day_of_week, hc_heb)
+
+#endif /* SRC_HC_DIRECT_H_ */
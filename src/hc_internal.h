@@ -1,27 +1,94 @@
 #ifndef SRC_HCONVERTER_INTERNAL_H_
 #define SRC_HCONVERTER_INTERNAL_H_
+#include <stdatomic.h>
+#include <stdio.h>
 #include "hconverter.h"
+#include "hc_direct.h"
+/* built in calendar implementations, registered from the start */
+extern hc_cal_impl greg_calendar;
+extern hc_cal_impl jul_calendar;
+extern hc_cal_impl heb_calendar;
+extern hc_cal_impl islamic_calendar;
+extern hc_cal_impl iso_week_calendar;
+
+/** Absolute day of 1 Muharram 1 AH (16 July 622 Julian) */
+extern const hc_abs_day ISLAMIC_BEGINNING;
+
+/** Julian day number (noon) minus absolute day, for astronomical computations */
+extern const hc_abs_day ABS_TO_JULIAN_DAY;
+
 /**
- * This struct contains pointers to specific functions in a calendar implementation.
+ * Layout of one Hebrew year, with its months in chronological order from Tishrei.
  */
-typedef struct hc_cal_impl_s {
-	long (*abs_date)(int year, int month, int day);
-	int (*compute_date)(long abs_date, hc_date *target);
-	int (*check_date)(int year, int month, int day);
-	int (*is_leap_year)(int year);
-	int (*month_length)(int year, int month);
-} hc_cal_impl;
+typedef struct heb_year_layout_s {
+	int year;
+	int leap;
+	heb_year_type type;
+	int months;                 /* 12 or 13 */
+	hc_abs_day rosh_hashana;    /* absolute day of 1 Tishrei */
+	hc_abs_day next_rosh_hashana; /* absolute day of 1 Tishrei of the next year */
+	int month[13];              /* month numbers, Nisan == 1 */
+	hc_abs_day month_start[13]; /* absolute day of the 1st of each month */
+	int month_length[13];
+} heb_year_layout;
+
+/** Compute the layout of a Hebrew year */
+void heb_year_layout_init(heb_year_layout *layout, int year);
 
-extern hc_cal_impl *greg_impl;
-extern hc_cal_impl *heb_impl;
-extern hc_cal_impl *jul_impl;
+/** Advance a layout to the following year; cheaper than starting over */
+void heb_year_layout_next(heb_year_layout *layout);
 
-/** Days since creation to start of Gregorian and Julian calendars */
-extern const long COMMON_BEGINNING;
+/** Compute the layout of the Hebrew year of an absolute day. Returns the
+    index of the day's month in the layout, -1 if the day is out of range. */
+int heb_year_layout_find(heb_year_layout *layout, hc_abs_day abs_date);
 
-/** Standard month lengths for Gregorian and Julian calendars */
-extern const int COMMON_MONTH_LENGTH[12];
+/** Move to the month after a Hebrew month, in chronological order */
+void heb_next_month(int *year, int *month);
+
+/** Transliterated name of a Hebrew month; Adar of a leap year is "Adar I" */
+const char *heb_month_name(int month, int leap);
 
 hc_cal_impl* get_calendar(hc_calendar_type calendar_type);
 
+/** Functions whose results are cached, see cache.c */
+typedef enum cache_kind { CACHE_CONVERT = 1, CACHE_MOLAD, CACHE_KEVIUT } cache_kind;
+
+/** A cached result: the outputs and the return value */
+typedef struct hc_cache_entry_s {
+	uint64_t key;
+	union {
+		struct {
+			hc_date date;
+			heb_time time;
+		};
+		int keviut[4];
+	};
+	int status;
+} hc_cache_entry;
+
+/** Bumped when a calendar is registered, to empty the caches */
+extern _Atomic unsigned cache_generation;
+
+/** The cached result of a call, NULL if there is none. *key is set to the key of
+    the call, or to 0 if the cache of the thread is off or the input cannot be cached. */
+hc_cache_entry *cache_find(cache_kind kind, int calendar, int year, int month, int day,
+		int target, uint64_t *key);
+
+/** The entry to store the result of a call in, after a miss with a non-zero key.
+    Computing the result may use the cache too, so get the entry only once done. */
+hc_cache_entry *cache_slot(uint64_t key);
+
+/** Maximum number of tokens in a command */
+#define CMD_TOKENS 7
+
+/** Split a command line, in place, into CMD_TOKENS tokens (NULL past the last one) */
+void cmd_tokenize(char *cmd, char **tokens);
+
+/** Canonical name of a command given any of its aliases, NULL if unknown */
+const char *cmd_name(const char *token);
+
+/** Run a tokenized command, writing its result to out.
+    Returns 0 on success, -1 on error, 1 for a quit command. */
+int run_cmd(char **cmd_tokenized, FILE *out);
+
 #endif
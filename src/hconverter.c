@@ -3,9 +3,10 @@
 #include <math.h>
 #include <stdio.h>
 
-extern hc_cal_impl *greg_impl;
-extern hc_cal_impl *heb_impl;
-extern hc_cal_impl *jul_impl;
+/* calendar implementations by calendar id */
+static hc_cal_impl *registry[HC_MAX_CALENDARS] = {
+	NULL, &greg_calendar, &jul_calendar, &heb_calendar, &islamic_calendar, &iso_week_calendar
+};
 
 int set_hc_date(hc_date* date, const int year, const int month,
 		const int day, const hc_calendar_type type)
@@ -25,49 +26,101 @@ hc_calendar_type hc_get_calendar_type(hc_date *date) { return date->calendar_typ
 
 hc_cal_impl *get_calendar(hc_calendar_type type)
 {
-	switch (type) {
-		case GREGORIAN: return greg_impl;
-		case JULIAN: return jul_impl;
-		case HEBREW: return heb_impl;
-		default: return NULL;
-	}
+	if ((unsigned)type >= HC_MAX_CALENDARS)
+		return NULL;
+	return registry[type];
 }
 
-int hc_convert(hc_date *date, hc_calendar_type target_calendar)
+int hc_register_calendar(const hc_calendar_type type, hc_cal_impl *impl)
+{
+	if (type == NONE || (unsigned)type >= HC_MAX_CALENDARS)
+		return -1;
+	registry[type] = impl;
+	atomic_fetch_add_explicit(&cache_generation, 1, memory_order_release);
+	return 0;
+}
+
+static int convert(hc_date *date, const hc_calendar_type target_calendar)
 {
 	hc_cal_impl *impl0, *impl1;
-	long abs_date;
+	hc_abs_day abs_date;
 	impl0 = get_calendar(date->calendar_type);
-	if (!impl0->check_date(date))
+	impl1 = get_calendar(target_calendar);
+	if (impl0 == NULL || impl1 == NULL)
+		return -1;
+	if (!impl0->check_date(date->year, date->month, date->day))
 		return -1;
 	abs_date = impl0->abs_date(date->year, date->month, date->day);
-	if (abs_date < 0) return -1;
-	impl1 = get_calendar(target_calendar);
+	if (abs_date < 1 || abs_date > HC_MAX_ABS_DATE) return -1;
 	return impl1->compute_date(abs_date, date);
 }
 
+int hc_convert(hc_date *date, hc_calendar_type target_calendar)
+{
+	uint64_t key;
+	hc_cache_entry *e = cache_find(CACHE_CONVERT, date->calendar_type, date->year, date->month,
+		date->day, target_calendar, &key);
+	int ret;
+
+	if (e != NULL) {
+		if (e->status == 0)
+			*date = e->date;
+		return e->status;
+	}
+	ret = convert(date, target_calendar);
+	if (key != 0) {
+		e = cache_slot(key);
+		e->date = *date;
+		e->status = ret;
+	}
+	return ret;
+}
+
 int hc_check(hc_date *date)
 {
 	hc_cal_impl *impl = get_calendar(date->calendar_type);
+	if (impl == NULL)
+		return 0;
 	return impl->check_date(date->year, date->month, date->day);
 }
 
 int hc_is_leap_year(int year, hc_calendar_type cal_type)
 {
 	hc_cal_impl *impl = get_calendar(cal_type);
+	if (impl == NULL)
+		return 0;
 	return impl->is_leap_year(year);
 }
 
 hc_day_of_week hc_get_day_of_week(hc_date *date)
 {
 	hc_cal_impl *impl = get_calendar(date->calendar_type);
-	long abs_date = impl->abs_date(date->year, date->month, date->day);
-	return (hc_day_of_week)(abs_date+1)%7;
+	hc_abs_day abs_date;
+	if (impl == NULL || (abs_date = impl->abs_date(date->year, date->month, date->day)) < 1)
+		return (hc_day_of_week)-1;
+	return (hc_day_of_week)((abs_date-1)%7);
 }
 
 int hc_get_month_length(int year, int month, hc_calendar_type calendar_type)
 {
 	hc_cal_impl *impl = get_calendar(calendar_type);
-	long abs_date = impl->month_length(year, month);
-	return (hc_day_of_week)(abs_date+1)%7;
+	if (impl == NULL)
+		return -1;
+	return impl->month_length(year, month);
+}
+
+hc_abs_day hc_get_abs_date(const hc_date *date)
+{
+	hc_cal_impl *impl = get_calendar(date->calendar_type);
+	if (impl == NULL || !impl->check_date(date->year, date->month, date->day))
+		return -1;
+	return impl->abs_date(date->year, date->month, date->day);
+}
+
+int hc_set_abs_date(hc_date *date, const hc_abs_day abs_date, const hc_calendar_type calendar_type)
+{
+	hc_cal_impl *impl = get_calendar(calendar_type);
+	if (impl == NULL || abs_date < 1 || abs_date > HC_MAX_ABS_DATE)
+		return -1;
+	return impl->compute_date(abs_date, date);
 }
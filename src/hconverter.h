@@ -17,8 +17,11 @@
 #ifndef SRC_HCONVERTER_H_
 #define SRC_HCONVERTER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*!
- * Convenience enum for days of week: <i>SUNDAY=0, MONDAY=1, ..., FRIDAY=6</i>
+ * Convenience enum for days of week: <i>SUNDAY=0, MONDAY=1, ..., SATURDAY=6</i>
  */
 typedef enum hc_day_of_week {SUNDAY, MONDAY, TUESDAY, WEDNESDAY,
 	THURSDAY, FRIDAY, SATURDAY} hc_day_of_week;
@@ -28,8 +31,14 @@ typedef enum hc_day_of_week {SUNDAY, MONDAY, TUESDAY, WEDNESDAY,
   \li GREGORIAN
   \li JULIAN
   \li HEBREW
+  \li ISLAMIC the tabular (arithmetical) Islamic calendar, civil epoch
+  \li ISO_WEEK ISO 8601 week dates: year, week 1-53 as month, weekday 1-7
+  (Monday is 1) as day
+
+  Further calendars, with ids up to HC_MAX_CALENDARS - 1, may be added at
+  run time with #hc_register_calendar.
  */
-typedef enum hc_calendar_type { NONE, GREGORIAN, JULIAN, HEBREW } hc_calendar_type;
+typedef enum hc_calendar_type { NONE, GREGORIAN, JULIAN, HEBREW, ISLAMIC, ISO_WEEK } hc_calendar_type;
 
 /**
  * Structure representing a date.
@@ -41,6 +50,30 @@ typedef struct hc_date_s {
     int day;
 } hc_date;
 
+/*!
+\brief An absolute day number (see #hc_get_abs_date).
+
+Days of the largest years do not fit in 32 bits, so they are carried in 64 on
+every platform, whatever the width of \c long.
+*/
+typedef int64_t hc_abs_day;
+
+/*!
+\brief Largest absolute day accepted (see #hc_get_abs_date).
+
+Dates of any calendar after this day are invalid, whatever their year, and
+are rejected in conversions as in the other functions.
+*/
+#define HC_MAX_ABS_DATE INT64_C(350000000000)
+/*!
+\brief Largest year accepted as input, in any calendar.
+
+This is the year of the Islamic calendar, the one with the shortest years, on
+#HC_MAX_ABS_DATE; the other calendars reach HC_MAX_ABS_DATE in earlier years,
+and reject the dates of those years that follow it.
+*/
+#define HC_MAX_YEAR 987673031
+
 /*!
  Convenience method to set the entire ::hc_date in one call.
  \param[out] date pointer to ::hc_date structure
@@ -85,7 +118,7 @@ instead of 12.
 
 \param[in] year Hebrew year >=1
 \param[in] calendar_type see #hc_calendar_type
-\return 1 for leap year, 0 for non-leap year
+\return 1 for leap year, 0 for non-leap year or a calendar not registered
 */
 int hc_is_leap_year(int year, hc_calendar_type calendar_type);
 
@@ -93,7 +126,8 @@ int hc_is_leap_year(int year, hc_calendar_type calendar_type);
 \brief Function to get day of week out of a ::hc_date.
 
 \param date
-\return a #hc_day of week: 0 for Saturday, 1 for Sunday, ..., 6 for Friday
+\return a #hc_day_of_week: 0 for Sunday, 1 for Monday, ..., 6 for Saturday, or
+-1 if the calendar is not registered or the month is out of range
 */
 hc_day_of_week hc_get_day_of_week(hc_date *date);
 
@@ -104,7 +138,7 @@ hc_day_of_week hc_get_day_of_week(hc_date *date);
 \param[in] month. For Hebrew, see (\ref hebmonth "note") about the special
 month order.
 \param[in] calendar_type see #hc_calendar_type
-\return length of month in days
+\return length of month in days, or -1 if the calendar is not registered
 */
 int hc_get_month_length(int year, int month, hc_calendar_type calendar_type);
 
@@ -120,7 +154,7 @@ they do not need.
 
 \param[in] year Hebrew year
 \param[out] rosh_hashana_dow Day of week for Eosh Hashana (1 Tishrei)
-\param[out] pesach_dow Day of week for Pesach (0 = saturday)
+\param[out] pesach_dow Day of week for Pesach (0 = Sunday)
 \param[out] ck returns 0, 1, 2 (SHORT, REGULAR, FULL) for number of days in
 excess of 58 in Chesh=van and Kislev combined. (see #hc_heb_year_type)
 \param[out] it will return 1 for leap years and 0 otherwise
@@ -201,6 +235,778 @@ typedef enum heb_year_type {SHORT_HEB_YEAR, NORMAL_HEB_YEAR, FULL_HEB_YEAR} heb_
 */
 heb_year_type hc_get_heb_year_type(int year);
 
+/*!
+\brief Get the absolute day number of a date.
+
+All calendars here are converted through a common axis of absolute days,
+counted from the Hebrew epoch (day 2 is Rosh Hashana of year 1). The
+number returned can be fed to the other day-keyed functions of this library
+or turned back into a date with #hc_set_abs_date.
+
+\param[in] date an ::hc_date
+\return absolute day number, or -1 if the calendar type is not supported or
+the date is invalid
+*/
+hc_abs_day hc_get_abs_date(const hc_date *date);
+
+/*!
+\brief Set an ::hc_date from an absolute day number.
+
+\param[out] date pointer to ::hc_date struct to store result
+\param[in] abs_date absolute day, see #hc_get_abs_date
+\param[in] calendar_type see #hc_calendar_type
+\return 0 on success, -1 if the day cannot be represented in the calendar or
+is beyond HC_MAX_ABS_DATE
+*/
+int hc_set_abs_date(hc_date *date, hc_abs_day abs_date, hc_calendar_type calendar_type);
+
+/*!
+\brief A place on Earth for which zmanim are computed.
+
+Latitude is positive north, longitude is positive east, both in degrees.
+Elevation is in meters above the surrounding horizon and may be left 0.
+Time zone is the offset of local standard time from UTC in hours; all times
+produced for the location are expressed in this time.
+*/
+typedef struct hc_location_s {
+	double latitude;
+	double longitude;
+	double elevation;
+	double time_zone;
+} hc_location;
+
+/*!
+\brief Halachic times of one day at one location.
+
+All times are in hours since local midnight (e.g. 6.5 is 06:30). A time
+that does not occur on that day, as in polar summer or winter, is NaN.
+
+\li \c alot         dawn, sun 16.1 degrees below the horizon
+\li \c sunrise      visible sunrise (hanetz hachama)
+\li \c chatzot      solar noon
+\li \c sunset       visible sunset (shkiah); the Hebrew date changes here
+\li \c tzeis        nightfall, sun 8.5 degrees below the horizon
+\li \c shaah_zmanit length of a halachic hour in hours, 1/12 of sunrise to sunset
+*/
+typedef struct hc_zmanim_s {
+	double alot;
+	double sunrise;
+	double chatzot;
+	double sunset;
+	double tzeis;
+	double shaah_zmanit;
+} hc_zmanim;
+
+/*!
+\brief Compute zmanim for one location over a range of days.
+
+The solar position is advanced from day to day incrementally, so long
+ranges cost little more than the per-day horizon computation.
+
+\param[in] loc location
+\param[in] from_abs first absolute day (see #hc_get_abs_date)
+\param[in] to_abs last absolute day, inclusive
+\param[out] out array of <tt>to_abs - from_abs + 1</tt> ::hc_zmanim, one per day
+\return 0 on success, -1 on invalid range
+*/
+int hc_zmanim_range(const hc_location *loc, hc_abs_day from_abs, hc_abs_day to_abs, hc_zmanim *out);
+
+/*!
+\brief Compute zmanim for many locations on one day.
+
+The solar position is computed once for the day, and only the horizon
+computation, a few trigonometric functions, is done for each location.
+
+\param[in] locs array of \c count locations
+\param[in] count number of locations
+\param[in] abs_date absolute day (see #hc_get_abs_date)
+\param[out] out array of \c count ::hc_zmanim, one per location
+\return 0 on success, -1 on invalid arguments
+*/
+int hc_zmanim_locations(const hc_location *locs, int count, hc_abs_day abs_date, hc_zmanim *out);
+
+/*!
+\brief Sort dates chronologically, whatever their calendars.
+
+Each date is converted to its absolute day once and the days are radix sorted,
+so the cost is linear in the number of dates. The sort is stable: dates on the
+same day keep their relative order. Dates are moved, not converted; each keeps
+its own calendar type.
+
+\param[in,out] dates array of dates to sort
+\param[in] count number of dates, at most 2^32-1
+\param[out] perm if not NULL, receives for every position of the sorted array
+the index the date had before sorting
+\return 0 on success, -1 on an unsupported calendar, an invalid date or out
+of memory, in which case the array is left unchanged
+*/
+int hc_sort_dates(hc_date *dates, size_t count, size_t *perm);
+
+/*!
+\brief Find the first date in a sorted array that is not before given date.
+
+\param[in] dates array sorted as by #hc_sort_dates
+\param[in] count number of dates
+\param[in] key date to look for, in any calendar
+\return index of the first date on or after \c key, \c count if none, or
+(size_t)-1 if \c key is not a valid date
+*/
+size_t hc_lower_bound(const hc_date *dates, size_t count, const hc_date *key);
+
+/*!
+\brief How often a recurring event repeats, see ::hc_rule.
+
+  \li YEARLY_RULE on a fixed month and day every year
+  \li MONTHLY_RULE on a fixed day of every month
+  \li ROSH_CHODESH_RULE on every Rosh Chodesh: the 1st of every Hebrew month
+  but Tishrei, and also the 30th of the preceding month when it has one
+*/
+typedef enum hc_rule_frequency {YEARLY_RULE, MONTHLY_RULE, ROSH_CHODESH_RULE} hc_rule_frequency;
+
+/*!
+\brief What a recurring event does in a year or month lacking its day.
+
+This covers days that exist only in some months or years, such as February 29,
+the 30th of Cheshvan, Kislev or Adar, or the 31st of a Gregorian month, as well
+as Adar in Hebrew leap years.
+
+  \li SKIP_MISSING no occurrence. A Hebrew rule on Adar (12) falls in Adar I on
+  leap years; a rule on Adar II (13) does not occur on common years.
+  \li EARLIER_IF_MISSING the last day of the month instead. A Hebrew rule on Adar
+  falls in Adar I on leap years; a rule on Adar II falls in Adar on common years.
+  \li LATER_IF_MISSING the day after the end of the month instead. A Hebrew rule
+  on Adar falls in Adar II on leap years; a rule on Adar II falls in Adar on
+  common years.
+*/
+typedef enum hc_leap_policy {SKIP_MISSING, EARLIER_IF_MISSING, LATER_IF_MISSING} hc_leap_policy;
+
+/*!
+\brief Rule of a recurring event.
+
+\c month is used by YEARLY_RULE only, \c day by YEARLY_RULE and MONTHLY_RULE.
+Hebrew months are numbered as in the (\ref hebmonth "note").
+*/
+typedef struct hc_rule_s {
+	hc_rule_frequency frequency;
+	hc_calendar_type calendar;
+	int month;
+	int day;
+	hc_leap_policy leap_policy;
+} hc_rule;
+
+/*!
+\brief Expand a recurring event over a range of days.
+
+Occurrences are written in increasing order as absolute days, which can be
+turned into dates of any calendar with #hc_set_abs_date. Each occurrence
+takes constant time to find. If \c out fills up, the expansion stops there and
+can be resumed from the day after the last occurrence written.
+
+\param[in] rule the recurring event, see ::hc_rule
+\param[in] from_abs first absolute day of the range (see #hc_get_abs_date)
+\param[in] to_abs last absolute day of the range, inclusive
+\param[out] out array to receive absolute days of the occurrences
+\param[in] max_out size of \c out
+\return number of occurrences written, -1 on an invalid rule or range
+*/
+int hc_expand(const hc_rule *rule, hc_abs_day from_abs, hc_abs_day to_abs, hc_abs_day *out, int max_out);
+
+/*!
+\brief Flags for #hc_format_hebrew, to be or-ed together.
+
+  \li FORMAT_HEBREW_LETTERS day and year in Hebrew letters, e.g. "ט״ו בניסן תשפ״ד" (default)
+  \li FORMAT_TRANSLITERATED digits and transliterated month, e.g. "15 Nisan 5784"
+  \li FORMAT_THOUSANDS with letters, also write the thousands of the year, e.g. "ה׳תשפ״ד";
+      a year that is a round thousand, e.g. "ה׳", always has them. Thousands
+      from 1000 up have no letters, so such years cannot be written with them
+  \li FORMAT_NO_YEAR leave out the year
+*/
+typedef enum hc_format_flags {FORMAT_HEBREW_LETTERS = 0, FORMAT_TRANSLITERATED = 1,
+	FORMAT_THOUSANDS = 2, FORMAT_NO_YEAR = 4} hc_format_flags;
+
+/*!
+\brief Format a date as a Hebrew date, in UTF-8.
+
+Dates of other calendars are converted first. In leap years the month Adar (12)
+is written as Adar I. The text is built from precomputed tables and written
+into the caller's buffer; no memory is allocated.
+
+\param[in] date an ::hc_date of any calendar
+\param[in] flags see #hc_format_flags
+\param[out] buf buffer for the text, always NUL terminated when \c size > 0
+\param[in] size size of \c buf in bytes; 64 is always enough
+\return number of bytes written, not counting the NUL, or -1 if the date is
+invalid, its thousands cannot be written (see #FORMAT_THOUSANDS) or the buffer
+too small
+*/
+int hc_format_hebrew(const hc_date *date, int flags, char *buf, size_t size);
+
+/*!
+\brief Set of Yamim Tovim kept, see #hc_is_business_day.
+
+  \li HOLIDAYS_ISRAEL one day of Yom Tov
+  \li HOLIDAYS_DIASPORA two days of Yom Tov (yom tov sheni) outside of Israel
+*/
+typedef enum hc_holiday_region {HOLIDAYS_ISRAEL, HOLIDAYS_DIASPORA} hc_holiday_region;
+
+/*!
+\brief Check whether a day is a business day, i.e. neither Shabbat nor Yom Tov.
+
+Yom Tov here means the days on which work is forbidden: Rosh Hashana (2 days),
+Yom Kippur, the first and last days of Sukkot and Pesach, and Shavuot, as well
+as their second days in the diaspora.
+
+\param[in] abs_date absolute day (see #hc_get_abs_date)
+\param[in] region see #hc_holiday_region
+\return 1 for a business day, 0 if not, -1 for an invalid day
+*/
+int hc_is_business_day(hc_abs_day abs_date, hc_holiday_region region);
+
+/*!
+\brief Count business days in a range of days.
+
+Non-working days are kept as a bitmap per Hebrew year, so the cost depends on
+the number of years spanned and not on the number of days.
+
+\param[in] from_abs first absolute day of the range
+\param[in] to_abs last absolute day of the range, inclusive
+\param[in] region see #hc_holiday_region
+\return number of business days, -1 for an invalid range
+*/
+hc_abs_day hc_count_business_days(hc_abs_day from_abs, hc_abs_day to_abs, hc_holiday_region region);
+
+/*!
+\brief Find the business day that is given number of business days after a day.
+
+The starting day itself is not counted, so with \c n = 1 this is the next
+business day. The cost depends on the number of years spanned.
+
+\param[in] from_abs starting absolute day
+\param[in] n number of business days to advance, >= 0
+\param[in] region see #hc_holiday_region
+\return absolute day reached, -1 for invalid arguments
+*/
+hc_abs_day hc_add_business_days(hc_abs_day from_abs, hc_abs_day n, hc_holiday_region region);
+
+/*!
+\brief A page (daf) of the Babylonian Talmud in the Daf Yomi cycle.
+
+\c tractate is an index from 0 (Berachot) to 39 (Niddah) in the order of
+learning; see #hc_tractate_name. \c page is the number of the daf.
+*/
+typedef struct hc_daf_s {
+	int cycle;
+	int tractate;
+	int page;
+} hc_daf;
+
+/*!
+\brief Name of a tractate, transliterated.
+
+\param[in] tractate index as in ::hc_daf
+\return static string, NULL for an invalid index
+*/
+const char *hc_tractate_name(int tractate);
+
+/*!
+\brief Absolute day on which a Daf Yomi cycle starts.
+
+The first cycle started on 11 September 1923. A cycle lasts 2711 days, or
+2702 days for cycles 1 to 7. A whole cycle is thus the range from the start
+of the cycle to the day before the start of the next one.
+
+\param[in] cycle number of the cycle, >= 1
+\return absolute day, -1 for an invalid cycle
+*/
+hc_abs_day hc_daf_yomi_cycle_start(int cycle);
+
+/*!
+\brief Find the page learned on a day in the Daf Yomi cycle.
+
+\param[in] abs_date absolute day (see #hc_get_abs_date)
+\param[out] daf pointer to ::hc_daf to store result
+\return 0 on success, -1 for a day before the first cycle
+*/
+int hc_daf_yomi(hc_abs_day abs_date, hc_daf *daf);
+
+/*!
+\brief Find the pages learned on every day of a range.
+
+Only the first day is looked up; after that pages are advanced one by one.
+
+\param[in] from_abs first absolute day of the range
+\param[in] to_abs last absolute day of the range, inclusive
+\param[out] out array of <tt>to_abs - from_abs + 1</tt> ::hc_daf, one per day
+\return 0 on success, -1 for an invalid range
+*/
+int hc_daf_yomi_range(hc_abs_day from_abs, hc_abs_day to_abs, hc_daf *out);
+
+/*!
+\brief Molad and true (astronomical) new moon of a Hebrew month.
+
+Instants are absolute days (see #hc_get_abs_date) with a fraction of a day,
+counted from midnight, in universal time. The molad, given by the calendar in
+Jerusalem mean time, is shifted to universal time by the longitude of Jerusalem.
+*/
+typedef struct hc_new_moon_s {
+	int year;            /*!< Hebrew year */
+	int month;           /*!< Hebrew month, see \ref hebmonth */
+	double molad;        /*!< instant of the molad */
+	double conjunction;  /*!< instant of the true conjunction of sun and moon */
+	double drift;        /*!< conjunction minus molad, in hours */
+} hc_new_moon;
+
+/*!
+\brief Compute the true new moons for a run of consecutive Hebrew months.
+
+The conjunction is found with the periodic terms of Meeus (Astronomical
+Algorithms, ch. 49) for the lunation nearest the molad of each month, and is
+accurate to about a minute for dates within a few centuries of the present;
+further away it is limited by the uncertainty of Delta T.
+
+\param[in] year Hebrew year of the first month
+\param[in] month first Hebrew month
+\param[in] count number of months
+\param[out] out array of \a count ::hc_new_moon to store results
+\return 0 on success, -1 for an invalid year, month or count, or a first molad
+after #HC_MAX_ABS_DATE
+*/
+int hc_compute_new_moons(int year, int month, int count, hc_new_moon *out);
+
+/*!
+\brief Number of possible keviut (see \ref keviut)
+*/
+#define KEVIUT_CLASSES 14
+
+/*!
+\brief Keviut class of a year.
+
+The classes are numbered 0 to 13; see #hc_keviut_class_info for what each one is.
+
+\param[in] year Hebrew year >= 1
+\return class 0 to 13, -1 for an invalid year
+*/
+int hc_keviut_class(int year);
+
+/*!
+\brief The keviut parameters of a class, as output by #hc_compute_keviut.
+
+Any of the output pointers may be NULL.
+\return 0 on success, -1 for an invalid class
+*/
+int hc_keviut_class_info(int keviut_class, int *rosh_hashana_dow, int *pesach_dow, int *ck, int *leap);
+
+/*!
+\brief Index of the keviut of a range of Hebrew years, built by #hc_keviut_index_init.
+
+For each class, one bit per year of the range, in \c words 64-bit words.
+*/
+typedef struct hc_keviut_index_s {
+	int first_year;
+	int last_year;
+	int previous_leap;  /*!< whether the year before first_year is leap */
+	size_t words;
+	uint64_t *bits;     /*!< KEVIUT_CLASSES bitmaps of \c words each */
+} hc_keviut_index;
+
+/*!
+\brief Conditions on a year, answered from an ::hc_keviut_index.
+
+Each field takes the value to match, as output by #hc_compute_keviut, or -1
+to match any. \c previous_leap is a condition on the year before.
+*/
+typedef struct hc_keviut_query_s {
+	int rosh_hashana_dow;
+	int pesach_dow;
+	int ck;
+	int leap;
+	int previous_leap;
+} hc_keviut_query;
+
+/*!
+\brief Build the keviut index of a range of Hebrew years.
+
+This allocates memory, which must be released with #hc_keviut_index_free.
+
+\param[out] index the index to build
+\param[in] first_year first Hebrew year of the range, >= 1
+\param[in] last_year last Hebrew year of the range, inclusive
+\return 0 on success, -1 on an invalid range or if out of memory
+*/
+int hc_keviut_index_init(hc_keviut_index *index, int first_year, int last_year);
+
+/*!
+\brief Release the memory held by a keviut index.
+*/
+void hc_keviut_index_free(hc_keviut_index *index);
+
+/*!
+\brief Count the years of an index that match a query.
+
+\return number of years, -1 on an invalid query
+*/
+long hc_keviut_count(const hc_keviut_index *index, const hc_keviut_query *query);
+
+/*!
+\brief List the years of an index that match a query.
+
+Years are written in increasing order. If \c years fills up, the search can
+be resumed from the year after the last one written.
+
+\param[in] index keviut index
+\param[in] query conditions to match
+\param[in] from_year first year to consider
+\param[out] years array to receive matching years
+\param[in] max_out size of \c years
+\return number of years written, -1 on an invalid query
+*/
+int hc_keviut_find(const hc_keviut_index *index, const hc_keviut_query *query, int from_year,
+		int *years, int max_out);
+
+/*!
+\brief Size of the calendar registry: calendar ids go from 1 to HC_MAX_CALENDARS - 1.
+*/
+#define HC_MAX_CALENDARS 16
+
+/*!
+\brief Arithmetic of one calendar, on the common axis of absolute days.
+
+\li \c abs_date absolute day of a (valid) date
+\li \c compute_date date of an absolute day, setting all fields of the ::hc_date
+    including its calendar type; 0 on success, -1 if out of range
+\li \c check_date 1 if a date is valid, 0 if not
+\li \c is_leap_year 1 for a leap year, 0 if not
+\li \c month_length days in a month, -1 for an invalid month
+*/
+typedef struct hc_cal_impl_s {
+	hc_abs_day (*abs_date)(int year, int month, int day);
+	int (*compute_date)(hc_abs_day abs_date, hc_date *target);
+	int (*check_date)(int year, int month, int day);
+	int (*is_leap_year)(int year);
+	int (*month_length)(int year, int month);
+} hc_cal_impl;
+
+/*!
+\brief Register a calendar implementation under an id.
+
+All calendar functions dispatch through this registry, so a registered
+calendar can be converted to and from any other. The built in calendars are
+registered from the start and may be replaced. Registration is not thread
+safe; do it before the calendar is used.
+
+Registering also invalidates the result caches of all threads (see
+#hc_cache_enable): each thread drops its cached results at its first cached
+call that starts after hc_register_calendar has returned.
+
+\param[in] calendar_type id of the calendar, 1 to HC_MAX_CALENDARS - 1
+\param[in] impl the implementation, which must outlive its use; NULL to remove
+\return 0 on success, -1 for an invalid id
+*/
+int hc_register_calendar(hc_calendar_type calendar_type, hc_cal_impl *impl);
+
+/*!
+\brief Receives the output of an ::hc_ics_writer, a chunk at a time.
+\return 0 on success, -1 to make the writer fail
+*/
+typedef int (*hc_ics_sink)(const char *data, size_t len, void *ctx);
+
+/*!
+\brief Size of the output buffer of an ::hc_ics_writer.
+*/
+#define HC_ICS_CHUNK 4096
+
+/*!
+\brief Streaming writer of an iCalendar (RFC 5545) feed.
+
+Output is collected in a fixed buffer and passed to the sink whenever the
+buffer fills, and at #hc_ics_end. Nothing is allocated, so memory does not grow
+with the range written. Events are all day; dates before the Gregorian
+calendar or after the year 9999 cannot be written.
+
+A feed is written by #hc_ics_begin, then any number of the \c hc_ics_add
+functions, then #hc_ics_end. The fields are private to the writer.
+*/
+typedef struct hc_ics_writer_s {
+	hc_ics_sink sink;
+	void *ctx;
+	int error;
+	char stamp[20];
+	size_t len;
+	char buf[HC_ICS_CHUNK];
+} hc_ics_writer;
+
+/*!
+\brief An ::hc_ics_sink writing to a <tt>FILE *</tt> passed as context.
+*/
+int hc_ics_file_sink(const char *data, size_t len, void *ctx);
+
+/*!
+\brief Start a feed.
+
+\param[out] w the writer
+\param[in] sink where output goes
+\param[in] ctx passed to the sink
+\param[in] name name of the calendar, or NULL
+\return 0 on success, -1 on an error
+*/
+int hc_ics_begin(hc_ics_writer *w, hc_ics_sink sink, void *ctx, const char *name);
+
+/*!
+\brief Add the Hebrew date of every day of a range, as in "15 Nisan 5784".
+
+\param[in,out] w the writer
+\param[in] from_abs first absolute day (see #hc_get_abs_date)
+\param[in] to_abs last absolute day, inclusive
+\return 0 on success, -1 on an invalid range or an error
+*/
+int hc_ics_add_hebrew_dates(hc_ics_writer *w, hc_abs_day from_abs, hc_abs_day to_abs);
+
+/*!
+\brief Add the molad of every month whose molad falls in a range.
+
+Each molad is an event on the civil day it falls on, with its time, in
+Jerusalem mean time, in the summary.
+
+\param[in,out] w the writer
+\param[in] from_abs first absolute day
+\param[in] to_abs last absolute day, inclusive
+\return 0 on success, -1 on an invalid range or an error
+*/
+int hc_ics_add_molads(hc_ics_writer *w, hc_abs_day from_abs, hc_abs_day to_abs);
+
+/*!
+\brief Add the occurrences of a recurring event over a range.
+
+A Gregorian rule that iCalendar can express is written as a single event
+with an RRULE; any other rule is expanded into one event per occurrence,
+which also has the Hebrew date as its description.
+
+\param[in,out] w the writer
+\param[in] rule the recurring event, see ::hc_rule
+\param[in] summary title of the event
+\param[in] from_abs first absolute day
+\param[in] to_abs last absolute day, inclusive
+\return 0 on success, -1 on an invalid rule or range or an error
+*/
+int hc_ics_add_rule(hc_ics_writer *w, const hc_rule *rule, const char *summary,
+		hc_abs_day from_abs, hc_abs_day to_abs);
+
+/*!
+\brief Finish a feed and flush the output.
+\return 0 if the whole feed was written, -1 if anything failed
+*/
+int hc_ics_end(hc_ics_writer *w);
+
+/*!
+\brief Everything about a day, as filled in by #hc_date_info.
+
+A conversion to a calendar the day is before the start of has the
+calendar type #NONE.
+*/
+typedef struct hc_info_s {
+	hc_abs_day abs_date;        /*!< see #hc_get_abs_date */
+	hc_date gregorian;
+	hc_date julian;
+	hc_date hebrew;
+	hc_day_of_week day_of_week;
+	heb_year_type year_type;    /*!< of the Hebrew year, see #hc_get_heb_year_type */
+	int leap;                   /*!< whether the Hebrew year is leap */
+	int rosh_hashana_dow;       /*!< the keviut of the Hebrew year, see #hc_compute_keviut */
+	int pesach_dow;
+	hc_date molad;              /*!< molad of the Hebrew month, as a Gregorian date */
+	heb_time molad_time;
+} hc_info;
+
+/*!
+\brief All the conversions and Hebrew year parameters of a date at once.
+
+Gives the same results as #hc_convert to each calendar, #hc_get_day_of_week,
+#hc_compute_keviut and #hc_compute_molad for the month, but finds the absolute
+day and the layout of the Hebrew year only once for all of them.
+
+\param[in] date a date of any calendar
+\param[out] out the information on the date
+\return 0 on success, -1 for an invalid date
+*/
+int hc_date_info(const hc_date *date, hc_info *out);
+
+/** Rows in a block of an ::hc_column */
+#define HC_COLUMN_BLOCK 256
+
+/*!
+\brief Summary of one block of an ::hc_column.
+
+Range scans look only at these, and skip the packed data of any block whose
+days are all outside the range.
+*/
+typedef struct hc_column_block_s {
+	hc_abs_day min;        /*!< smallest absolute day in the block */
+	hc_abs_day max;        /*!< largest absolute day in the block */
+	hc_abs_day first;      /*!< absolute day of the first row of the block */
+	hc_abs_day min_delta;  /*!< smallest difference between consecutive rows */
+	size_t offset;         /*!< first word of the packed differences in hc_column::data */
+	int width;             /*!< bits per packed difference */
+} hc_column_block;
+
+/*!
+\brief A compressed column of dates.
+
+The dates are kept as absolute days, in blocks of #HC_COLUMN_BLOCK rows. A
+block holds its first day, and the difference from each row to the next,
+less the smallest such difference, packed in as few bits as the largest one
+needs. Dates that are mostly sorted and close together take a few bits each.
+Built with #hc_column_encode or #hc_column_load, released with #hc_column_free.
+*/
+typedef struct hc_column_s {
+	size_t rows;
+	size_t blocks;
+	size_t words;              /*!< length of data */
+	hc_column_block *index;    /*!< one entry per block */
+	uint64_t *data;            /*!< packed differences of all the blocks */
+} hc_column;
+
+/*!
+\brief Compress a sequence of dates, of any calendars, into a column.
+\param[out] col the column, to be released with #hc_column_free
+\param[in] dates the dates, in any order
+\param[in] rows number of dates
+\return 0 on success, -1 for an invalid date or if out of memory
+*/
+int hc_column_encode(hc_column *col, const hc_date *dates, size_t rows);
+
+/*!
+\brief Compress a sequence of absolute days into a column.
+\param[out] col the column, to be released with #hc_column_free
+\param[in] days absolute days from 1 to #HC_MAX_ABS_DATE (see #hc_get_abs_date)
+\param[in] rows number of days
+\return 0 on success, -1 for a day out of range or if out of memory
+*/
+int hc_column_encode_abs(hc_column *col, const hc_abs_day *days, size_t rows);
+
+/*!
+\brief Release the memory of a column.
+*/
+void hc_column_free(hc_column *col);
+
+/*!
+\brief Size of the stored form of a column, in bytes; see #hc_column_store.
+*/
+size_t hc_column_stored_size(const hc_column *col);
+
+/*!
+\brief Write a column to a buffer, for saving to disk.
+
+The stored form is the same on all machines: integers are little endian.
+
+\param[in] col the column
+\param[out] buf at least #hc_column_stored_size bytes
+\return number of bytes written
+*/
+size_t hc_column_store(const hc_column *col, unsigned char *buf);
+
+/*!
+\brief Read a column written by #hc_column_store.
+\param[out] col the column, to be released with #hc_column_free
+\param[in] buf the stored column
+\param[in] len length of buf
+\return 0 on success, -1 if buf does not hold a valid column or if out of memory
+*/
+int hc_column_load(hc_column *col, const unsigned char *buf, size_t len);
+
+/*!
+\brief Decode rows of a column into absolute days.
+\param[in] col the column
+\param[in] first_row first row to decode
+\param[out] out absolute days
+\param[in] count number of rows to decode
+\return number of rows decoded, less than count at the end of the column; -1 on error
+*/
+int hc_column_decode_abs(const hc_column *col, size_t first_row, hc_abs_day *out, int count);
+
+/*!
+\brief Decode rows of a column into dates of a calendar.
+
+Gregorian, Julian and Hebrew dates are found from the year of the previous
+row where possible, so runs of rows in the same year cost little more than
+decoding the days.
+
+\param[in] col the column
+\param[in] first_row first row to decode
+\param[in] cal calendar of the dates
+\param[out] out dates
+\param[in] count number of rows to decode
+\return number of rows decoded, less than count at the end of the column;
+-1 on error, or if a day is before the start of the calendar
+*/
+int hc_column_decode(const hc_column *col, size_t first_row, hc_calendar_type cal,
+		hc_date *out, int count);
+
+/*!
+\brief Find the rows of a column with days in a range.
+
+Blocks with no day in the range are skipped without being decoded. To
+continue a scan that filled the output, call again with start_row one past
+the last row found.
+
+\param[in] col the column
+\param[in] from_abs first absolute day of the range
+\param[in] to_abs last absolute day of the range, inclusive
+\param[in] start_row row to start at
+\param[out] rows row numbers found, in order; may be NULL
+\param[in] cal calendar of dates, used only if dates is not NULL
+\param[out] dates dates of the rows found; may be NULL
+\param[in] max_out capacity of rows and dates
+\return number of rows found, up to max_out; -1 on error
+*/
+int hc_column_scan(const hc_column *col, hc_abs_day from_abs, hc_abs_day to_abs, size_t start_row,
+		size_t *rows, hc_calendar_type cal, hc_date *dates, int max_out);
+
+/** Entries in the result cache of each thread */
+#define HC_CACHE_SLOTS 4096
+
+/*!
+\brief Counters of the result cache of a thread, see #hc_cache_enable.
+*/
+typedef struct hc_cache_stats_s {
+	unsigned long lookups;      /*!< calls that went through the cache */
+	unsigned long hits;         /*!< of those, the ones answered from it */
+	unsigned long evictions;    /*!< results dropped to make room for others */
+} hc_cache_stats;
+
+/*!
+\brief Turn the result cache of the calling thread on or off.
+
+With the cache on, #hc_convert, #hc_compute_molad and #hc_compute_keviut
+remember the results of up to #HC_CACHE_SLOTS recent inputs, and return
+them without computing again when called with the same input. This pays off
+where a few distinct dates make up most of the calls. Each thread has its
+own cache, which is off to begin with. Its memory is allocated at the first
+call made with the cache on, and freed by #hc_cache_clear or when the
+thread exits.
+
+\param[in] on 1 to turn the cache on, 0 to turn it off
+*/
+void hc_cache_enable(int on);
+
+/*!
+\brief Whether the result cache of the calling thread is on.
+*/
+int hc_cache_is_enabled(void);
+
+/*!
+\brief The counters of the result cache of the calling thread.
+\param[out] stats the counters since the thread started or last cleared its cache
+*/
+void hc_cache_get_stats(hc_cache_stats *stats);
+
+/*!
+\brief Empty the result cache of the calling thread and reset its counters.
+
+This also frees the memory of the cache; it is allocated again at the next
+call made with the cache on. Whether the cache is on does not change.
+*/
+void hc_cache_clear(void);
+
 /*!
 \file
 
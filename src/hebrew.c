@@ -1,11 +1,12 @@
 #include "hconverter.h"
 #include "hc_internal.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 
 typedef struct abs_heb_time {
-    long abs_date;
+    hc_abs_day abs_date;
     int hour;
     int part;
 } hc_abs_heb_time;
@@ -29,16 +30,18 @@ typedef enum HEB_MONTH {NULL_MONTH, NISAN, IYAR, SIVAN, TAMUZ, AV, ELUL,
     TISHREI, CHESHVAN, KISLEV, TEVETH, SHVAT, ADAR, ADAR_2} heb_month;
 
 
-int heb_is_leap_year(const int year)
+int hc_heb_is_leap_year(const int year)
 {
     /* check for leapness of a Hebrew year */
     static const int leap_map[19] = { 1, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0 };
+	if (year < 0)
+		return 0;
 	return leap_map[year % 19];
 }
 
 static int heb_month_length(const int year, const int month)
 {
-    if (month < 1 || month > 12 + heb_is_leap_year(year))
+    if (month < 1 || month > 12 + hc_heb_is_leap_year(year))
         return 0;
     switch (month) {
         case NISAN:
@@ -56,7 +59,7 @@ static int heb_month_length(const int year, const int month)
             return 29;
 
         case ADAR:
-            return heb_is_leap_year ? 30 : 29;
+            return hc_heb_is_leap_year(year) ? 30 : 29;
         case CHESHVAN:
             return hc_get_heb_year_type(year) == FULL_HEB_YEAR ? 30 : 29;
         case KISLEV:
@@ -69,13 +72,15 @@ static int heb_month_length(const int year, const int month)
 
 
 
-static int heb_check_date(const int year, const int month, const int day)
+int hc_heb_check_date(const int year, const int month, const int day)
 {
-	if (year < 1)
-		return 1;
-	if (month > 13 || (month == 13 && !heb_is_leap_year(year)))
-		return 1;
-	return day > 0 && day <= heb_month_length(year, month);
+	if (year < 1 || year > HC_MAX_YEAR)
+		return 0;
+	if (month < 1 || month > 13 || (month == 13 && !hc_heb_is_leap_year(year)))
+		return 0;
+	if (day < 1 || day > heb_month_length(year, month))
+		return 0;
+	return year <= HC_MAX_FULL_YEAR || hc_heb_to_abs_date(year, month, day) <= HC_MAX_ABS_DATE;
 }
 
 /* subroutine to add parts
@@ -98,23 +103,16 @@ static void add_parts (hc_abs_heb_time *target, const hc_abs_heb_time *to_add)
     }
 }
 
-/* multiplication of parts here */
-static hc_abs_heb_time mult_parts(const long days, const int hours, const int parts, const long int times)
+/* multiplication of parts here; done on a 64-bit count of parts, which
+   holds the molads of all years up to HC_MAX_YEAR with room to spare */
+static hc_abs_heb_time mult_parts(const hc_abs_day days, const int hours, const int parts, const int64_t times)
 {
   hc_abs_heb_time ret;
-  long int D = days * times;
-  long int H = hours * times;
-  long int P = parts * times;
+  const int64_t P = (((int64_t)days * 24 + hours) * 1080 + parts) * times;
 
-  H += P/1080;
-  P = P % 1080;
-
-  D += H/24;
-  H = H % 24;
-
-  ret.abs_date = D;
-  ret.hour = H;
-  ret.part = P;
+  ret.abs_date = (hc_abs_day)(P / (24 * 1080));
+  ret.hour = (int)(P / 1080 % 24);
+  ret.part = (int)(P % 1080);
 
   return ret;
 }
@@ -127,23 +125,12 @@ static int compute_abs_molad_rosh_hashana(const int year, hc_abs_heb_time *abs_t
 	abs_time->abs_date = 2;
 	abs_time->hour = 5;
 	abs_time->part = 204;
-	long pre_months;
+	int64_t pre_months;
 
-    /*
-        yr is number of years since first molad, in other words the year
-        when the molad of Rosh Hashana occurs (in end of Elul).
-    */
-	int yr = year - 1;
-	int cycles = yr / 19;
-	int i;
-
-	/* count number of months since beginning to molad of Rosh Hashana
-	   There are 19*12+7 months per cycle */
-	pre_months = 235 * cycles;
-	for (i = 0; i < (yr % 19); i++)
-	{
-		pre_months += 12 + heb_is_leap_year(i+1);
-	}
+	/* count number of months since beginning to molad of Rosh Hashana.
+	   There are 19*12+7 months per cycle, the 7 leap months spread evenly
+	   enough that the count comes out of a single division */
+	pre_months = (235 * (int64_t)year - 234) / 19;
 
 	/* now call mult_parts  */
 
@@ -155,11 +142,11 @@ static int compute_abs_molad_rosh_hashana(const int year, hc_abs_heb_time *abs_t
 
 /* Calculate absolute day of Rosh Hashanah
    by first taking Molad and applying dehiyot as necessary  */
-static long rosh_hashana_abs_date(const int year)
+static hc_abs_day rosh_hashana_abs_date(const int year)
 {
 	hc_abs_heb_time molad;
 	compute_abs_molad_rosh_hashana(year, &molad);
-	long int day = molad.abs_date;
+	hc_abs_day day = molad.abs_date;
 	hc_day_of_week dw = (day-1) % 7;
 
 	/* Now come the 3 dehiyot. These are as follows:
@@ -169,10 +156,10 @@ static long rosh_hashana_abs_date(const int year)
     */
 	if (    molad.hour >= 18
 		/* ^^^ molad zoken ^^^ */
-		|| ( ! heb_is_leap_year(year) && dw == TUESDAY &&
+		|| ( ! hc_heb_is_leap_year(year) && dw == TUESDAY &&
 			( molad.hour> 9 || (molad.hour == 9 && molad.part >= 204)))
 		/* ^^^ gatra"d b'shanah pdhutah b'rosh ^^^ */
-		|| ( heb_is_leap_year(year-1)  && dw == MONDAY &&
+		|| ( hc_heb_is_leap_year(year-1)  && dw == MONDAY &&
 			( molad.hour > 15  || (molad.hour == 15 && molad.part >= 589) ))
 		/* ^^^ Dehiyyah BeTU'TeKaPoT ^^^ */) {
 		day++;
@@ -191,9 +178,9 @@ static long rosh_hashana_abs_date(const int year)
 
 heb_year_type hc_get_heb_year_type(const int year)
 {
-	const long r0 = rosh_hashana_abs_date(year);
-	const long r1 = rosh_hashana_abs_date(year+1);
-	long year_length = r1 -r0;
+	const hc_abs_day r0 = rosh_hashana_abs_date(year);
+	const hc_abs_day r1 = rosh_hashana_abs_date(year+1);
+	hc_abs_day year_length = r1 -r0;
 	heb_year_type t;
 	if (year_length < 360)
 		t = year_length - 353;
@@ -202,113 +189,294 @@ heb_year_type hc_get_heb_year_type(const int year)
 	return t;
 }
 
-/* convert Hebrew day to absolute */
-static long heb_to_abs_date (const int year, const int month, const int day)
+/* fill in the layout of a year from its and the next year's Rosh Hashana */
+static void fill_year_layout(heb_year_layout *layout, const int year, const hc_abs_day r0, const hc_abs_day r1)
 {
-	// Hebrew months are numbered from Tishrei, which is month 7. This is
-	// because and additional month on leap year is inserted in Adar, and it
-	// is more convenient to have Adar 12th in order. Thus we start with 7, and
-	// then wrap up.
-	int mon = 7;
-
-	long ret = rosh_hashana_abs_date(year) - 1;
-	int months_in_year = 13 + heb_is_leap_year(year);
-	while ( mon != month ) {
-		ret += heb_month_length (year, mon);
-		mon = (mon + 1) % months_in_year;
+	/* month order from Tishrei */
+	static const int common_months[12] = { TISHREI, CHESHVAN, KISLEV, TEVETH, SHVAT, ADAR,
+		NISAN, IYAR, SIVAN, TAMUZ, AV, ELUL };
+	static const int leap_months[13] = { TISHREI, CHESHVAN, KISLEV, TEVETH, SHVAT, ADAR, ADAR_2,
+		NISAN, IYAR, SIVAN, TAMUZ, AV, ELUL };
+	/* month lengths by month number; -1 depends on the year */
+	static const int lengths[14] = { 0, 30, 29, 30, 29, 30, 29, 30, -1, -1, 29, 30, -1, 29 };
+	const hc_abs_day year_length = r1 - r0;
+	const int *months;
+	hc_abs_day start = r0;
+	int i;
+
+	layout->year = year;
+	layout->leap = hc_heb_is_leap_year(year);
+	layout->type = year_length < 360 ? year_length - 353 : year_length - 383;
+	layout->months = 12 + layout->leap;
+	layout->rosh_hashana = r0;
+	layout->next_rosh_hashana = r1;
+	months = layout->leap ? leap_months : common_months;
+
+	for (i = 0; i < layout->months; i++) {
+		int m = months[i];
+		int len = lengths[m];
+		if (m == CHESHVAN)
+			len = layout->type == FULL_HEB_YEAR ? 30 : 29;
+		else if (m == KISLEV)
+			len = layout->type == SHORT_HEB_YEAR ? 29 : 30;
+		else if (m == ADAR)
+			len = layout->leap ? 30 : 29;
+		layout->month[i] = m;
+		layout->month_start[i] = start;
+		layout->month_length[i] = len;
+		start += len;
 	}
-	ret += day;
-	return ret;
 }
 
-static int heb_compute_date(const long abs_date, hc_date *target)
+void heb_year_layout_init(heb_year_layout *layout, const int year)
 {
-    target->calendar_type = HEBREW;
+	fill_year_layout(layout, year, rosh_hashana_abs_date(year), rosh_hashana_abs_date(year+1));
+}
+
+void heb_year_layout_next(heb_year_layout *layout)
+{
+	const int year = layout->year + 1;
+	fill_year_layout(layout, year, layout->next_rosh_hashana, rosh_hashana_abs_date(year+1));
+}
 
-	long int absday = abs_date - 1;
-	long int premon;
-	int dy, mh=7, yr, ml;
+void heb_next_month(int *year, int *month)
+{
+	if (*month == ELUL) {
+		(*year)++;
+		*month = TISHREI;
+	} else if (*month == ADAR && hc_heb_is_leap_year(*year)) {
+		*month = ADAR_2;
+	} else if (*month >= ADAR) {
+		*month = NISAN;
+	} else {
+		(*month)++;
+	}
+}
 
+/* convert Hebrew day to absolute */
+hc_abs_day hc_heb_to_abs_date(const int year, const int month, const int day)
+{
+	// Hebrew months are numbered from Tishrei, which is month 7. This is
+	// because and additional month on leap year is inserted in Adar, and it
+	// is more convenient to have Adar 12th in order. The layout of the year
+	// has the months in order from Tishrei with the day each one starts.
+	heb_year_layout layout;
+	int i;
 
-	/* first find out what is the current Hebrew year.
-     get a reasonable lower bound for the year first so we won't
-     have to count through thousands of years...
-     Yes, this is not most efficient, I'll make a better approximation later. */
-	premon = absday/29.7 - 1;
-	yr = (premon/235)*19;
+	if (year < 1 || year > HC_MAX_YEAR)
+		return -1;
+	heb_year_layout_init(&layout, year);
+	for (i = 0; i < layout.months; i++) {
+		if (layout.month[i] == month)
+			return layout.month_start[i] + day - 1;
+	}
+	return -1;
+}
 
-    /** molad is faster to compute until we get to the last year */
-    while (rosh_hashana_abs_date(yr+1) <= abs_date)
-        yr++;
+int heb_year_layout_find(heb_year_layout *layout, const hc_abs_day abs_date)
+{
+	hc_abs_day r0, r1;
+	int yr, i;
 
-	/* Ok, seems we got the right year now */
-	target->year = yr;
-	dy = abs_date - rosh_hashana_abs_date(yr) + 1;
+	if (abs_date < 2 || abs_date > HC_MAX_ABS_DATE)
+		return -1;
 
-	/* count as we go through the year; start with Tishrei and save rewinding the cycle */
-	while ((ml = heb_month_length(yr, mh)) < dy) {
-		dy -= ml;
-		mh++;
-		mh = ((mh-1) % (12+heb_is_leap_year(yr)))+1;
+	/* first find out what is the current Hebrew year. Years are on average
+	   35975351/98496 days long (235 months in 19 years); Rosh Hashana stays
+	   within a month of its mean position, so the year from the mean is off
+	   by one at most, and at most one step corrects it. */
+	yr = (int)(98496 * (abs_date - 2) / 35975351) + 1;
+	r0 = rosh_hashana_abs_date(yr);
+	if (r0 > abs_date) {
+		r1 = r0;
+		r0 = rosh_hashana_abs_date(--yr);
+	} else if ((r1 = rosh_hashana_abs_date(yr + 1)) <= abs_date) {
+		r0 = r1;
+		r1 = rosh_hashana_abs_date(++yr + 1);
 	}
 
-	target->month = mh;
-	target->day = dy;
+	/* then the month, from the last one starting on or before the day */
+	fill_year_layout(layout, yr, r0, r1);
+	for (i = layout->months - 1; layout->month_start[i] > abs_date; i--)
+		;
+	return i;
+}
+
+int hc_heb_compute_date(const hc_abs_day abs_date, hc_date *target)
+{
+	heb_year_layout layout;
+	const int i = heb_year_layout_find(&layout, abs_date);
+
+	if (i < 0)
+		return -1;
+	target->year = layout.year;
+	target->month = layout.month[i];
+	target->day = (int)(abs_date - layout.month_start[i]) + 1;
 	target->calendar_type = HEBREW;
 	return 0;
 }
 
-int hc_compute_molad(const int year, const int month, const hc_calendar_type cal_type,
+/* molad of a month, given as its index in the year counting from Tishrei */
+static void month_molad(const int year, const int index, hc_abs_heb_time *molad)
+{
+	compute_abs_molad_rosh_hashana(year, molad);
+	if (index != 0) {
+		hc_abs_heb_time to_add = mult_parts(29, 12, 793, index);
+		add_parts(molad, &to_add);
+	}
+}
+
+static int compute_molad(const int year, const int month, const hc_calendar_type cal_type,
 		hc_date *date, heb_time *time)
 {
 	hc_abs_heb_time molad;
-	compute_abs_molad_rosh_hashana(year, &molad);
-	if (month != 7) {
-		int num_months = heb_is_leap_year(year) ? 13 : 12;
-		hc_abs_heb_time to_add = mult_parts(29, 12, 793, (month-7)%num_months);
-		add_parts(&molad, &to_add);
-	}
-	heb_compute_date(molad.abs_date, date);
-	if (cal_type != HEBREW)
-		hc_convert(date, cal_type);
+	int num_months;
+
+	if (year < 1 || year > HC_MAX_YEAR || month < 1 || month > 12 + hc_heb_is_leap_year(year))
+		return -1;
+	num_months = hc_heb_is_leap_year(year) ? 13 : 12;
+	month_molad(year, (month - 7 + num_months) % num_months, &molad);
+	if (hc_heb_compute_date(molad.abs_date, date) != 0)
+		return -1;
+	if (cal_type != HEBREW && hc_convert(date, cal_type) != 0)
+		return -1;
 
 	hc_set_hc_heb_time(time, molad.hour, molad.part);
 	return 0;
 }
 
+int hc_compute_molad(const int year, const int month, const hc_calendar_type cal_type,
+		hc_date *date, heb_time *time)
+{
+	uint64_t key;
+	hc_cache_entry *e = cache_find(CACHE_MOLAD, HEBREW, year, month, 0, cal_type, &key);
+	int ret;
+
+	if (e != NULL) {
+		if (e->status == 0) {
+			*date = e->date;
+			*time = e->time;
+		}
+		return e->status;
+	}
+	ret = compute_molad(year, month, cal_type, date, time);
+	if (key != 0) {
+		e = cache_slot(key);
+		e->date = *date;
+		e->time = *time;
+		e->status = ret;
+	}
+	return ret;
+}
+
 int hc_compute_molad_rosh_hashana(const int year, const hc_calendar_type cal_type,
 		hc_date *date, heb_time *time)
 {
-	return hc_compute_molad(year, 1, cal_type, date, time);
+	return hc_compute_molad(year, 7, cal_type, date, time);
+}
+
+/* the keviut of a year from its layout: Rosh Hashana and Pesach weekdays,
+   year type and leap; Nisan follows Adar, or Adar II in a leap year */
+static void layout_keviut(const heb_year_layout *layout, int *keviut)
+{
+	keviut[0] = (int)((layout->rosh_hashana - 1) % 7);
+	keviut[1] = (int)((layout->month_start[6 + layout->leap] + 14 - 1) % 7);
+	keviut[2] = layout->type;
+	keviut[3] = layout->leap;
 }
 
 int hc_compute_keviut(const int year, int *rosh_hashana_dow, int *pesach_begin_dow, int *ck, int *leap)
 {
-	long rosh, pesach;
-	if (year < 1)
+	heb_year_layout layout;
+	hc_cache_entry *e;
+	uint64_t key;
+	int keviut[4];
+
+	if (year < 1 || year > HC_MAX_YEAR)
 		return -1;
-	rosh = rosh_hashana_abs_date(year);
+	if ((e = cache_find(CACHE_KEVIUT, HEBREW, year, 0, 0, 0, &key)) != NULL) {
+		memcpy(keviut, e->keviut, sizeof(keviut));
+	} else {
+		heb_year_layout_init(&layout, year);
+		layout_keviut(&layout, keviut);
+		if (key != 0) {
+			e = cache_slot(key);
+			memcpy(e->keviut, keviut, sizeof(keviut));
+			e->status = 0;
+		}
+	}
 	if (rosh_hashana_dow != NULL)
-		*rosh_hashana_dow = (rosh + 1) % 7;
-	pesach = heb_to_abs_date(year, 1, 15);
+		*rosh_hashana_dow = keviut[0];
 	if (pesach_begin_dow != NULL)
-		*pesach_begin_dow = (pesach + 1) % 7;
+		*pesach_begin_dow = keviut[1];
 	if (ck != NULL)
-		*ck = hc_get_heb_year_type(year);
+		*ck = keviut[2];
 	if (leap != NULL)
-		*leap = heb_is_leap_year(year);
+		*leap = keviut[3];
 	return 0;
 }
 
+int hc_date_info(const hc_date *date, hc_info *out)
+{
+	heb_year_layout layout;
+	hc_abs_heb_time molad;
+	hc_cal_impl *impl;
+	int keviut[4], i;
+
+	if (date == NULL || out == NULL)
+		return -1;
+
+	/* the Hebrew date and the layout of its year, found once for all the fields;
+	   a Hebrew date is checked against the layout itself */
+	if (date->calendar_type == HEBREW) {
+		if (date->year < 1 || date->year > HC_MAX_YEAR)
+			return -1;
+		heb_year_layout_init(&layout, date->year);
+		for (i = 0; i < layout.months && layout.month[i] != date->month; i++)
+			;
+		if (i == layout.months || date->day < 1 || date->day > layout.month_length[i])
+			return -1;
+		out->abs_date = layout.month_start[i] + date->day - 1;
+		if (out->abs_date > HC_MAX_ABS_DATE)
+			return -1;
+		out->hebrew = *date;
+	} else {
+		impl = get_calendar(date->calendar_type);
+		if (impl == NULL || !impl->check_date(date->year, date->month, date->day))
+			return -1;
+		out->abs_date = impl->abs_date(date->year, date->month, date->day);
+		if ((i = heb_year_layout_find(&layout, out->abs_date)) < 0)
+			return -1;
+		out->hebrew.calendar_type = HEBREW;
+		out->hebrew.year = layout.year;
+		out->hebrew.month = layout.month[i];
+		out->hebrew.day = (int)(out->abs_date - layout.month_start[i]) + 1;
+	}
+	if (hc_greg_compute_date(out->abs_date, &out->gregorian) != 0)
+		out->gregorian.calendar_type = NONE;
+	if (hc_jul_compute_date(out->abs_date, &out->julian) != 0)
+		out->julian.calendar_type = NONE;
+	out->day_of_week = (hc_day_of_week)((out->abs_date - 1) % 7);
+
+	layout_keviut(&layout, keviut);
+	out->rosh_hashana_dow = keviut[0];
+	out->pesach_dow = keviut[1];
+	out->year_type = keviut[2];
+	out->leap = keviut[3];
+
+	month_molad(layout.year, i, &molad);
+	if (hc_greg_compute_date(molad.abs_date, &out->molad) != 0)
+		out->molad.calendar_type = NONE;
+	hc_set_hc_heb_time(&out->molad_time, molad.hour, molad.part);
+	return 0;
+}
 
 /* set handles */
-static hc_cal_impl hc_heb_impl_s =
+hc_cal_impl heb_calendar =
 {
-    heb_to_abs_date,
-    heb_compute_date,
-	heb_check_date,
-	heb_is_leap_year,
+    hc_heb_to_abs_date,
+    hc_heb_compute_date,
+	hc_heb_check_date,
+	hc_heb_is_leap_year,
 	heb_month_length
 };
-
-hc_cal_impl *heb_impl = &hc_heb_impl_s;
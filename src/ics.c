@@ -0,0 +1,319 @@
+/**
+ Streaming export to iCalendar (RFC 5545).
+
+ Content lines are formatted into a fixed buffer inside the writer, which is
+ handed to a sink every time it fills up, so memory use does not depend on
+ the length of the range. Days are walked along the absolute-day axis with
+ the Gregorian and Hebrew dates advanced one day at a time. A recurring rule
+ that is purely Gregorian becomes a single VEVENT with an RRULE; any other
+ rule is expanded with hc_expand, a fixed-size batch at a time.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/** Occurrences of a rule expanded at a time */
+#define EXPAND_BATCH 64
+
+/** Longest content line, in octets, before it is folded */
+#define MAX_LINE 75
+
+/** Longest summary, in octets, after escaping */
+#define MAX_SUMMARY 256
+
+static const char *const WEEKDAY_NAMES[7] = {
+	"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
+};
+
+static void flush(hc_ics_writer *w)
+{
+	if (w->len > 0 && !w->error && w->sink(w->buf, w->len, w->ctx) != 0)
+		w->error = 1;
+	w->len = 0;
+}
+
+static void put(hc_ics_writer *w, const char *data, size_t len)
+{
+	while (len > 0) {
+		size_t n = HC_ICS_CHUNK - w->len;
+		if (n > len)
+			n = len;
+		memcpy(w->buf + w->len, data, n);
+		w->len += n;
+		data += n;
+		len -= n;
+		if (w->len == HC_ICS_CHUNK)
+			flush(w);
+	}
+}
+
+/* write a content line, folded every 75 octets without splitting a UTF-8 character */
+static void line(hc_ics_writer *w, const char *fmt, ...)
+{
+	char text[MAX_SUMMARY + 64];
+	size_t len, pos = 0, limit = MAX_LINE;
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(text, sizeof(text), fmt, ap);
+	va_end(ap);
+	if (n < 0 || (size_t)n >= sizeof(text)) {
+		w->error = 1;
+		return;
+	}
+	len = (size_t)n;
+	while (len - pos > limit) {
+		size_t cut = pos + limit;
+		while (cut > pos + 1 && ((unsigned char)text[cut] & 0xC0) == 0x80)
+			cut--;
+		put(w, text + pos, cut - pos);
+		put(w, "\r\n ", 3);
+		pos = cut;
+		/* the leading space of a continuation line counts */
+		limit = MAX_LINE - 1;
+	}
+	put(w, text + pos, len - pos);
+	put(w, "\r\n", 2);
+}
+
+/* escape a TEXT value; truncated, at a character boundary, if too long */
+static void escape(const char *src, char *dst)
+{
+	size_t n = 0;
+
+	for (; *src; src++) {
+		const char *rep = NULL;
+		char one[2] = { *src, '\0' };
+		size_t len;
+
+		switch (*src) {
+		case '\\': rep = "\\\\"; break;
+		case ';': rep = "\\;"; break;
+		case ',': rep = "\\,"; break;
+		case '\n': rep = "\\n"; break;
+		case '\r': continue;
+		default: rep = one;
+		}
+		len = strlen(rep);
+		if (n + len >= MAX_SUMMARY) {
+			/* drop the start of a character cut short */
+			if (((unsigned char)*src & 0xC0) == 0x80) {
+				while (n > 0 && ((unsigned char)dst[n - 1] & 0xC0) == 0x80)
+					n--;
+				if (n > 0)
+					n--;
+			}
+			break;
+		}
+		memcpy(dst + n, rep, len);
+		n += len;
+	}
+	dst[n] = '\0';
+}
+
+/* 32-bit FNV-1a, to make stable event ids from a summary */
+static unsigned long text_hash(const char *s)
+{
+	unsigned long h = 2166136261UL;
+	for (; *s; s++)
+		h = ((h ^ (unsigned char)*s) * 16777619UL) & 0xFFFFFFFFUL;
+	return h;
+}
+
+/* Gregorian date of an absolute day; -1 if iCalendar cannot represent it */
+static int ics_date(const hc_abs_day abs_date, hc_date *g)
+{
+	if (hc_set_abs_date(g, abs_date, GREGORIAN) != 0 || g->year > 9999)
+		return -1;
+	return 0;
+}
+
+/* an all day event; rrule and description may be NULL */
+static void event(hc_ics_writer *w, const char *uid, const hc_date *g, const char *summary,
+		const char *description, const char *rrule)
+{
+	line(w, "BEGIN:VEVENT");
+	line(w, "UID:%s@hconverter", uid);
+	line(w, "DTSTAMP:%s", w->stamp);
+	line(w, "DTSTART;VALUE=DATE:%04d%02d%02d", g->year, g->month, g->day);
+	line(w, "SUMMARY:%s", summary);
+	if (description != NULL)
+		line(w, "DESCRIPTION:%s", description);
+	if (rrule != NULL)
+		line(w, "RRULE:%s", rrule);
+	line(w, "END:VEVENT");
+}
+
+/* advance a Gregorian or Hebrew date by one day */
+static void next_day(hc_date *d)
+{
+	if (++d->day <= hc_get_month_length(d->year, d->month, d->calendar_type))
+		return;
+	d->day = 1;
+	if (d->calendar_type == HEBREW) {
+		heb_next_month(&d->year, &d->month);
+	} else if (++d->month > 12) {
+		d->month = 1;
+		d->year++;
+	}
+}
+
+int hc_ics_file_sink(const char *data, const size_t len, void *ctx)
+{
+	return fwrite(data, 1, len, (FILE *)ctx) == len ? 0 : -1;
+}
+
+int hc_ics_begin(hc_ics_writer *w, hc_ics_sink sink, void *ctx, const char *name)
+{
+	const time_t now = time(NULL);
+	struct tm tm;
+	char text[MAX_SUMMARY];
+
+	if (w == NULL || sink == NULL)
+		return -1;
+	w->sink = sink;
+	w->ctx = ctx;
+	w->len = 0;
+	w->error = 0;
+	gmtime_r(&now, &tm);
+	strftime(w->stamp, sizeof(w->stamp), "%Y%m%dT%H%M%SZ", &tm);
+
+	line(w, "BEGIN:VCALENDAR");
+	line(w, "VERSION:2.0");
+	line(w, "PRODID:-//hconverter//Hebrew calendar//EN");
+	line(w, "CALSCALE:GREGORIAN");
+	if (name != NULL) {
+		escape(name, text);
+		line(w, "X-WR-CALNAME:%s", text);
+	}
+	return w->error ? -1 : 0;
+}
+
+int hc_ics_end(hc_ics_writer *w)
+{
+	if (w == NULL)
+		return -1;
+	line(w, "END:VCALENDAR");
+	flush(w);
+	return w->error ? -1 : 0;
+}
+
+int hc_ics_add_hebrew_dates(hc_ics_writer *w, const hc_abs_day from_abs, const hc_abs_day to_abs)
+{
+	hc_date g, h;
+	char uid[32], summary[64];
+	hc_abs_day a;
+
+	if (w == NULL || to_abs < from_abs || ics_date(to_abs, &g) != 0)
+		return -1;
+	if (ics_date(from_abs, &g) != 0 || hc_set_abs_date(&h, from_abs, HEBREW) != 0)
+		return -1;
+	for (a = from_abs; a <= to_abs && !w->error; a++) {
+		sprintf(uid, "hd-%lld", (long long)a);
+		if (hc_format_hebrew(&h, FORMAT_TRANSLITERATED, summary, sizeof(summary)) < 0)
+			return -1;
+		event(w, uid, &g, summary, NULL, NULL);
+		next_day(&g);
+		next_day(&h);
+	}
+	return w->error ? -1 : 0;
+}
+
+int hc_ics_add_molads(hc_ics_writer *w, const hc_abs_day from_abs, const hc_abs_day to_abs)
+{
+	hc_date h, d;
+	heb_time t;
+	char uid[32], summary[128];
+
+	/* a molad may fall a day or two away from Rosh Chodesh: start a month early */
+	if (w == NULL || to_abs < from_abs
+			|| hc_set_abs_date(&h, from_abs > 31 ? from_abs - 31 : 1, HEBREW) != 0)
+		return -1;
+	for (; !w->error; heb_next_month(&h.year, &h.month)) {
+		hc_abs_day day;
+		int hour;
+
+		hc_compute_molad(h.year, h.month, HEBREW, &d, &t);
+		/* the Hebrew day starts at 6 pm of the civil day before */
+		day = hc_get_abs_date(&d);
+		hour = t.hour - 6;
+		if (hour < 0) {
+			hour += 24;
+			day--;
+		}
+		if (day > to_abs)
+			break;
+		if (day < from_abs)
+			continue;
+		if (ics_date(day, &d) != 0)
+			return -1;
+		sprintf(uid, "molad-%d-%d", h.year, h.month);
+		sprintf(summary, "Molad %s %d: %s %d:%02d and %d chalakim",
+			heb_month_name(h.month, hc_heb_is_leap_year(h.year)), h.year,
+			WEEKDAY_NAMES[(day - 1) % 7], hour, t.part / 18, t.part % 18);
+		event(w, uid, &d, summary, NULL, NULL);
+	}
+	return w->error ? -1 : 0;
+}
+
+/* rules that iCalendar can repeat by itself: Gregorian, on a day every month has
+   or else skipped where missing, as RRULE does */
+static int gregorian_rrule(const hc_rule *rule, const hc_abs_day until, char *out)
+{
+	hc_date g;
+
+	if (rule->calendar != GREGORIAN || rule->frequency == ROSH_CHODESH_RULE
+			|| (rule->day > 28 && rule->leap_policy != SKIP_MISSING)
+			|| ics_date(until, &g) != 0)
+		return 0;
+	if (rule->frequency == YEARLY_RULE)
+		sprintf(out, "FREQ=YEARLY;BYMONTH=%d;BYMONTHDAY=%d;UNTIL=%04d%02d%02d",
+			rule->month, rule->day, g.year, g.month, g.day);
+	else
+		sprintf(out, "FREQ=MONTHLY;BYMONTHDAY=%d;UNTIL=%04d%02d%02d", rule->day, g.year, g.month, g.day);
+	return 1;
+}
+
+int hc_ics_add_rule(hc_ics_writer *w, const hc_rule *rule, const char *summary,
+		const hc_abs_day from_abs, const hc_abs_day to_abs)
+{
+	hc_abs_day batch[EXPAND_BATCH], start = from_abs;
+	char text[MAX_SUMMARY], uid[48], rrule[80], hebrew[64];
+	hc_date g, h;
+	const unsigned long hash = summary != NULL ? text_hash(summary) : 0;
+	int n, i;
+
+	if (w == NULL || summary == NULL)
+		return -1;
+	escape(summary, text);
+
+	n = hc_expand(rule, start, to_abs, batch, 1);
+	if (n <= 0)
+		return n;
+	if (gregorian_rrule(rule, to_abs, rrule)) {
+		if (ics_date(batch[0], &g) != 0)
+			return -1;
+		sprintf(uid, "rule-%08lx-%lld", hash, (long long)batch[0]);
+		event(w, uid, &g, text, NULL, rrule);
+		return w->error ? -1 : 0;
+	}
+
+	while (!w->error && (n = hc_expand(rule, start, to_abs, batch, EXPAND_BATCH)) > 0) {
+		for (i = 0; i < n; i++) {
+			if (ics_date(batch[i], &g) != 0)
+				return -1;
+			hc_set_abs_date(&h, batch[i], HEBREW);
+			hc_format_hebrew(&h, FORMAT_TRANSLITERATED, hebrew, sizeof(hebrew));
+			sprintf(uid, "rule-%08lx-%lld", hash, (long long)batch[i]);
+			event(w, uid, &g, text, hebrew, NULL);
+		}
+		if (n < EXPAND_BATCH)
+			break;
+		start = batch[n - 1] + 1;
+	}
+	return n < 0 || w->error ? -1 : 0;
+}
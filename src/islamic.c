@@ -0,0 +1,72 @@
+/**
+ The tabular Islamic calendar: 12 months alternating 30 and 29 days, with a
+ 30th day added to the last month in 11 years of every 30 (years 2, 5, 7,
+ 10, 13, 16, 18, 21, 24, 26 and 29 of the cycle). The epoch is the civil one,
+ Friday 16 July 622 (Julian).
+
+ All conversions are closed formulas, with no loops.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+
+const hc_abs_day ISLAMIC_BEGINNING = 1600444;
+
+static int isl_is_leap_year(const int year)
+{
+	return (14 + 11 * (hc_abs_day)year) % 30 < 11;
+}
+
+static int isl_month_length(const int year, const int month)
+{
+	if (month < 1 || month > 12)
+		return -1;
+	if (month == 12)
+		return 29 + isl_is_leap_year(year);
+	return month % 2 ? 30 : 29;
+}
+
+static hc_abs_day isl_to_abs_date(const int year, const int month, const int day)
+{
+	/* months before: 29 days each, plus one for every odd month */
+	return ISLAMIC_BEGINNING - 1 + day + 29L * (month - 1) + month / 2
+		+ 354 * (hc_abs_day)(year - 1) + (3 + 11 * (hc_abs_day)year) / 30;
+}
+
+static int isl_check_date(const int year, const int month, const int day)
+{
+	if (year < 1 || year > HC_MAX_YEAR || month < 1 || month > 12)
+		return 0;
+	if (day < 1 || day > isl_month_length(year, month))
+		return 0;
+	return year <= HC_MAX_FULL_YEAR || isl_to_abs_date(year, month, day) <= HC_MAX_ABS_DATE;
+}
+
+static int isl_compute_date(const hc_abs_day abs_date, hc_date *target)
+{
+	hc_abs_day days;
+	int year, month;
+
+	if (abs_date < ISLAMIC_BEGINNING || abs_date > HC_MAX_ABS_DATE)
+		return -1;
+	/* 10631 days in a cycle of 30 years */
+	year = (int)((30 * (abs_date - ISLAMIC_BEGINNING) + 10646) / 10631);
+	days = abs_date - isl_to_abs_date(year, 1, 1);
+	/* the n-th month starts on day ceil(29.5 * (n - 1)) of the year */
+	month = (int)(2 * days / 59) + 1;
+	if (month > 12)
+		month = 12;
+
+	target->year = year;
+	target->month = month;
+	target->day = (int)(abs_date - isl_to_abs_date(year, month, 1)) + 1;
+	target->calendar_type = ISLAMIC;
+	return 0;
+}
+
+hc_cal_impl islamic_calendar = {
+	isl_to_abs_date,
+	isl_compute_date,
+	isl_check_date,
+	isl_is_leap_year,
+	isl_month_length
+};
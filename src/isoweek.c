@@ -0,0 +1,69 @@
+/**
+ ISO 8601 week dates. The year is divided into weeks from Monday to Sunday;
+ week 1 is the one with the year's first Thursday (equivalently, with 4
+ January), so a year has 52 or 53 weeks. In an ::hc_date the week is kept as
+ the month and the weekday, 1 for Monday to 7 for Sunday, as the day.
+
+ A "leap" year here is one of 53 weeks.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include "hc_direct.h"
+
+/* absolute day of the Monday of week 1 */
+static hc_abs_day iso_first_monday(const int year)
+{
+	const hc_abs_day jan4 = hc_greg_to_abs_date(year, 1, 4);
+	/* (abs - 1) % 7 is 0 on Sunday, so (abs + 5) % 7 is 0 on Monday */
+	return jan4 - (jan4 + 5) % 7;
+}
+
+static int iso_is_leap_year(const int year)
+{
+	return iso_first_monday(year + 1) - iso_first_monday(year) == 53 * 7;
+}
+
+static int iso_month_length(const int year, const int week)
+{
+	if (week < 1 || week > 52 + iso_is_leap_year(year))
+		return -1;
+	return 7;
+}
+
+static hc_abs_day iso_to_abs_date(const int year, const int week, const int day)
+{
+	return iso_first_monday(year) + 7L * (week - 1) + day - 1;
+}
+
+static int iso_check_date(const int year, const int week, const int day)
+{
+	if (year < 1 || year > HC_MAX_YEAR || week < 1 || week > 52 + iso_is_leap_year(year))
+		return 0;
+	if (day < 1 || day > 7)
+		return 0;
+	return year <= HC_MAX_FULL_YEAR || iso_to_abs_date(year, week, day) <= HC_MAX_ABS_DATE;
+}
+
+static int iso_compute_date(const hc_abs_day abs_date, hc_date *target)
+{
+	const int weekday = (int)((abs_date + 5) % 7);
+	/* the week belongs to the Gregorian year of its Thursday */
+	const hc_abs_day thursday = abs_date - weekday + 3;
+	hc_date g;
+
+	if (hc_greg_compute_date(thursday, &g) != 0)
+		return -1;
+	target->year = g.year;
+	target->month = (int)((thursday - hc_greg_to_abs_date(g.year, 1, 1)) / 7) + 1;
+	target->day = weekday + 1;
+	target->calendar_type = ISO_WEEK;
+	return 0;
+}
+
+hc_cal_impl iso_week_calendar = {
+	iso_to_abs_date,
+	iso_compute_date,
+	iso_check_date,
+	iso_is_leap_year,
+	iso_month_length
+};
@@ -0,0 +1,210 @@
+/**
+ Inverted index of keviut: for each of the 14 possible year patterns, a
+ bitmap over a range of Hebrew years, one bit per year.
+
+ The index is built with a single walk of year layouts. A query names the
+ weekday of Rosh Hashana, the weekday of Pesach, the length of Cheshvan and
+ Kislev, whether the year is leap and whether the previous year was leap, any
+ of which may be left open. Each condition becomes the union of the class
+ bitmaps it admits, and the conditions are intersected a 64-bit word at a time.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdlib.h>
+
+#define ALL_CLASSES ((1U << KEVIUT_CLASSES) - 1)
+
+/** The 14 keviut as (Rosh Hashana weekday, Pesach weekday, ck, leap) */
+static const int CLASSES[KEVIUT_CLASSES][4] = {
+	{MONDAY, TUESDAY, SHORT_HEB_YEAR, 0},
+	{MONDAY, THURSDAY, FULL_HEB_YEAR, 0},
+	{TUESDAY, THURSDAY, NORMAL_HEB_YEAR, 0},
+	{THURSDAY, SATURDAY, NORMAL_HEB_YEAR, 0},
+	{THURSDAY, SUNDAY, FULL_HEB_YEAR, 0},
+	{SATURDAY, SUNDAY, SHORT_HEB_YEAR, 0},
+	{SATURDAY, TUESDAY, FULL_HEB_YEAR, 0},
+	{MONDAY, THURSDAY, SHORT_HEB_YEAR, 1},
+	{MONDAY, SATURDAY, FULL_HEB_YEAR, 1},
+	{TUESDAY, SATURDAY, NORMAL_HEB_YEAR, 1},
+	{THURSDAY, SUNDAY, SHORT_HEB_YEAR, 1},
+	{THURSDAY, TUESDAY, FULL_HEB_YEAR, 1},
+	{SATURDAY, TUESDAY, SHORT_HEB_YEAR, 1},
+	{SATURDAY, THURSDAY, FULL_HEB_YEAR, 1}
+};
+
+static int class_of(const int rosh_hashana_dow, const int ck, const int leap)
+{
+	int c;
+	for (c = 0; c < KEVIUT_CLASSES; c++) {
+		if (CLASSES[c][0] == rosh_hashana_dow && CLASSES[c][2] == ck && CLASSES[c][3] == leap)
+			return c;
+	}
+	return -1;
+}
+
+int hc_keviut_class(const int year)
+{
+	int rh, ck, leap;
+	if (hc_compute_keviut(year, &rh, NULL, &ck, &leap) != 0)
+		return -1;
+	return class_of(rh, ck, leap);
+}
+
+int hc_keviut_class_info(const int keviut_class, int *rosh_hashana_dow, int *pesach_dow, int *ck, int *leap)
+{
+	if (keviut_class < 0 || keviut_class >= KEVIUT_CLASSES)
+		return -1;
+	if (rosh_hashana_dow != NULL)
+		*rosh_hashana_dow = CLASSES[keviut_class][0];
+	if (pesach_dow != NULL)
+		*pesach_dow = CLASSES[keviut_class][1];
+	if (ck != NULL)
+		*ck = CLASSES[keviut_class][2];
+	if (leap != NULL)
+		*leap = CLASSES[keviut_class][3];
+	return 0;
+}
+
+int hc_keviut_index_init(hc_keviut_index *index, const int first_year, const int last_year)
+{
+	heb_year_layout layout;
+	int year;
+
+	if (index == NULL || first_year < 1 || last_year < first_year)
+		return -1;
+	index->first_year = first_year;
+	index->last_year = last_year;
+	index->words = (size_t)(last_year - first_year) / 64 + 1;
+	index->bits = calloc(KEVIUT_CLASSES * index->words, sizeof(uint64_t));
+	if (index->bits == NULL)
+		return -1;
+	index->previous_leap = first_year > 1 && hc_heb_is_leap_year(first_year - 1);
+
+	heb_year_layout_init(&layout, first_year);
+	for (year = first_year; ; year++) {
+		const size_t bit = (size_t)(year - first_year);
+		const int c = class_of((int)((layout.rosh_hashana - 1) % 7), layout.type, layout.leap);
+		index->bits[c * index->words + bit / 64] |= 1ULL << (bit % 64);
+		if (year == last_year)
+			break;
+		heb_year_layout_next(&layout);
+	}
+	return 0;
+}
+
+void hc_keviut_index_free(hc_keviut_index *index)
+{
+	if (index == NULL)
+		return;
+	free(index->bits);
+	index->bits = NULL;
+	index->words = 0;
+}
+
+/* set of classes, as a mask, that satisfy one condition; -1 admits all */
+static unsigned admitted(const int column, const int value)
+{
+	unsigned mask = 0;
+	int c;
+	if (value < 0)
+		return ALL_CLASSES;
+	for (c = 0; c < KEVIUT_CLASSES; c++) {
+		if (CLASSES[c][column] == value)
+			mask |= 1U << c;
+	}
+	return mask;
+}
+
+/* union of the bitmaps of a set of classes, for one word */
+static uint64_t union_word(const hc_keviut_index *index, const unsigned mask, const size_t w)
+{
+	uint64_t r = 0;
+	int c;
+	for (c = 0; c < KEVIUT_CLASSES; c++) {
+		if (mask & (1U << c))
+			r |= index->bits[c * index->words + w];
+	}
+	return r;
+}
+
+/* years of one word matching the query */
+static uint64_t match_word(const hc_keviut_index *index, const hc_keviut_query *query,
+		const unsigned masks[4], const unsigned leap_mask, const size_t w)
+{
+	uint64_t r = ~0ULL;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (masks[i] != ALL_CLASSES)
+			r &= union_word(index, masks[i], w);
+	}
+	if (query->previous_leap >= 0) {
+		/* leap years shifted on by one year */
+		uint64_t prev = union_word(index, leap_mask, w) << 1;
+		prev |= w > 0 ? union_word(index, leap_mask, w - 1) >> 63 : (uint64_t)index->previous_leap;
+		r &= query->previous_leap ? prev : ~prev;
+	}
+	if (w == index->words - 1 && (index->last_year - index->first_year + 1) % 64)
+		r &= (1ULL << ((index->last_year - index->first_year + 1) % 64)) - 1;
+	return r;
+}
+
+static int prepare(const hc_keviut_index *index, const hc_keviut_query *query,
+		unsigned masks[4], unsigned *leap_mask)
+{
+	int i;
+
+	if (index == NULL || index->bits == NULL || query == NULL
+			|| query->rosh_hashana_dow > SATURDAY || query->pesach_dow > SATURDAY
+			|| query->ck > FULL_HEB_YEAR || query->leap > 1 || query->previous_leap > 1)
+		return -1;
+	masks[0] = admitted(0, query->rosh_hashana_dow);
+	masks[1] = admitted(1, query->pesach_dow);
+	masks[2] = admitted(2, query->ck);
+	masks[3] = admitted(3, query->leap);
+	*leap_mask = admitted(3, 1);
+	for (i = 0; i < 4; i++) {
+		if (masks[i] == 0)
+			return 0;
+	}
+	return 1;
+}
+
+long hc_keviut_count(const hc_keviut_index *index, const hc_keviut_query *query)
+{
+	unsigned masks[4], leap_mask;
+	long count = 0;
+	size_t w;
+	const int ok = prepare(index, query, masks, &leap_mask);
+
+	if (ok <= 0)
+		return ok;
+	for (w = 0; w < index->words; w++)
+		count += __builtin_popcountll(match_word(index, query, masks, leap_mask, w));
+	return count;
+}
+
+int hc_keviut_find(const hc_keviut_index *index, const hc_keviut_query *query, const int from_year,
+		int *years, const int max_out)
+{
+	unsigned masks[4], leap_mask;
+	int count = 0;
+	size_t w;
+	const int ok = prepare(index, query, masks, &leap_mask);
+
+	if (ok < 0 || years == NULL || max_out < 0)
+		return -1;
+	if (ok == 0 || from_year > index->last_year)
+		return 0;
+	w = from_year > index->first_year ? (size_t)(from_year - index->first_year) / 64 : 0;
+	for (; w < index->words && count < max_out; w++) {
+		uint64_t r = match_word(index, query, masks, leap_mask, w);
+		while (r && count < max_out) {
+			const int year = index->first_year + (int)(64 * w) + __builtin_ctzll(r);
+			if (year >= from_year)
+				years[count++] = year;
+			r &= r - 1;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,216 @@
+/**
+ True (astronomical) new moon, to compare with the mean molad.
+
+ The instant of conjunction is computed with the periodic terms of Meeus,
+ Astronomical Algorithms, chapter 49, good to well under a minute for many
+ centuries around the present. The lunation number is seeded from the molad,
+ which never strays from the true new moon by more than about 14 hours, and
+ the terms are held in parallel arrays and summed in a plain loop, one sine
+ each. Dynamical time is turned into universal time with the polynomial
+ expressions of Espenak and Meeus for Delta T.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <math.h>
+#include <stddef.h>
+
+#define PI 3.14159265358979323846
+#define DEG (PI / 180.0)
+
+/** Julian ephemeris day of the mean new moon of lunation 0 (6 January 2000) */
+#define NEW_MOON_EPOCH 2451550.09766
+#define SYNODIC_MONTH 29.530588861
+
+/** Parts (1/1080 hour) in the mean lunation of the Hebrew calendar: 29d 12h 793p */
+#define LUNATION_PARTS ((29L * 24 + 12) * 1080 + 793)
+#define PARTS_PER_DAY (24L * 1080)
+
+/** Longitude of Jerusalem, in days of time: the molad is in its local mean time */
+#define JERUSALEM_OFFSET (35.2354 / 360)
+
+#define NUM_TERMS 25
+#define NUM_PLANETARY 14
+
+/* Periodic terms for the new moon: coefficient (days), power of E, and
+   multiples of M (sun's anomaly), M' (moon's anomaly), F (argument of
+   latitude) and Omega (longitude of the node) in the argument */
+static const double TERM_COEF[NUM_TERMS] = {
+	-0.40720, 0.17241, 0.01608, 0.01039, 0.00739, -0.00514, 0.00208, -0.00111,
+	-0.00057, 0.00056, -0.00042, 0.00042, 0.00038, -0.00024, -0.00017, -0.00007,
+	0.00004, 0.00004, 0.00003, 0.00003, -0.00003, 0.00003, -0.00002, -0.00002,
+	0.00002
+};
+static const int TERM_E[NUM_TERMS] = {
+	0, 1, 0, 0, 1, 1, 2, 0, 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+static const double TERM_M[NUM_TERMS] = {
+	0, 1, 0, 0, -1, 1, 2, 0, 0, 1, 0, 1, 1, -1, 0, 2, 0, 3, 1, 0, 1, -1, -1, 1, 0
+};
+static const double TERM_MP[NUM_TERMS] = {
+	1, 0, 2, 0, 1, 1, 0, 1, 1, 2, 3, 0, 0, 2, 0, 1, 2, 0, 1, 2, 1, 1, 1, 3, 4
+};
+static const double TERM_F[NUM_TERMS] = {
+	0, 0, 0, 2, 0, 0, 0, -2, 2, 0, 0, 2, -2, 0, 0, 0, -2, 0, -2, 2, 2, 2, -2, 0, 0
+};
+static const double TERM_OM[NUM_TERMS] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Additional corrections for the planets: argument A = base + rate * k
+   - t2 * T^2 (only A1 has a T^2 term), and coefficient (days) */
+static const double PLANETARY_BASE[NUM_PLANETARY] = {
+	299.77, 251.88, 251.83, 349.42, 84.66, 141.74, 207.14, 154.84, 34.52,
+	207.19, 291.34, 161.72, 239.56, 331.55
+};
+static const double PLANETARY_RATE[NUM_PLANETARY] = {
+	0.107408, 0.016321, 26.651886, 36.412478, 18.206239, 53.303771, 2.453732,
+	7.306860, 27.261239, 0.121824, 1.844379, 24.198154, 25.513099, 3.592518
+};
+static const double PLANETARY_T2[NUM_PLANETARY] = {
+	0.009173, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+static const double PLANETARY_COEF[NUM_PLANETARY] = {
+	0.000325, 0.000165, 0.000164, 0.000126, 0.000110, 0.000062, 0.000060,
+	0.000056, 0.000047, 0.000042, 0.000040, 0.000037, 0.000035, 0.000023
+};
+
+/* reduce an angle in degrees to [0, 360) before converting, to keep precision */
+static double radians(const double degrees)
+{
+	return fmod(degrees, 360.0) * DEG;
+}
+
+/* Delta T = TT - UT in seconds, Espenak and Meeus (2006) */
+static double delta_t(const double y)
+{
+	double t, u;
+
+	if (y < -500 || y >= 2150) {
+		u = (y - 1820) / 100;
+		return -20 + 32 * u * u;
+	}
+	if (y < 500) {
+		u = y / 100;
+		return 10583.6 + u * (-1014.41 + u * (33.78311 + u * (-5.952053
+			+ u * (-0.1798452 + u * (0.022174192 + u * 0.0090316521)))));
+	}
+	if (y < 1600) {
+		u = (y - 1000) / 100;
+		return 1574.2 + u * (-556.01 + u * (71.23472 + u * (0.319781
+			+ u * (-0.8503463 + u * (-0.005050998 + u * 0.0083572073)))));
+	}
+	if (y < 1700) {
+		t = y - 1600;
+		return 120 + t * (-0.9808 + t * (-0.01532 + t / 7129));
+	}
+	if (y < 1800) {
+		t = y - 1700;
+		return 8.83 + t * (0.1603 + t * (-0.0059285 + t * (0.00013336 - t / 1174000)));
+	}
+	if (y < 1860) {
+		t = y - 1800;
+		return 13.72 + t * (-0.332447 + t * (0.0068612 + t * (0.0041116 + t * (-0.00037436
+			+ t * (0.0000121272 + t * (-0.0000001699 + t * 0.000000000875))))));
+	}
+	if (y < 1900) {
+		t = y - 1860;
+		return 7.62 + t * (0.5737 + t * (-0.251754 + t * (0.01680668
+			+ t * (-0.0004473624 + t / 233174))));
+	}
+	if (y < 1920) {
+		t = y - 1900;
+		return -2.79 + t * (1.494119 + t * (-0.0598939 + t * (0.0061966 - t * 0.000197)));
+	}
+	if (y < 1941) {
+		t = y - 1920;
+		return 21.20 + t * (0.84493 + t * (-0.076100 + t * 0.0020936));
+	}
+	if (y < 1961) {
+		t = y - 1950;
+		return 29.07 + t * (0.407 + t * (-1.0 / 233 + t / 2547));
+	}
+	if (y < 1986) {
+		t = y - 1975;
+		return 45.45 + t * (1.067 + t * (-1.0 / 260 - t / 718));
+	}
+	if (y < 2005) {
+		t = y - 2000;
+		return 63.86 + t * (0.3345 + t * (-0.060374 + t * (0.0017275
+			+ t * (0.000651814 + t * 0.00002373599))));
+	}
+	if (y < 2050) {
+		t = y - 2000;
+		return 62.92 + t * (0.32217 + t * 0.005589);
+	}
+	u = (y - 1820) / 100;
+	return -20 + 32 * u * u - 0.5628 * (2150 - y);
+}
+
+/* Julian ephemeris day of the true new moon of lunation k */
+static double true_new_moon(const double k)
+{
+	const double t = k / 1236.85, t2 = t * t, t3 = t2 * t, t4 = t3 * t;
+	const double e = 1 - 0.002516 * t - 0.0000074 * t2;
+	const double e_pow[3] = { 1, e, e * e };
+	const double m = radians(2.5534 + 29.10535670 * k - 0.0000014 * t2 - 0.00000011 * t3);
+	const double mp = radians(201.5643 + 385.81693528 * k + 0.0107582 * t2 + 0.00001238 * t3
+		- 0.000000058 * t4);
+	const double f = radians(160.7108 + 390.67050284 * k - 0.0016118 * t2 - 0.00000227 * t3
+		+ 0.000000011 * t4);
+	const double om = radians(124.7746 - 1.56375588 * k + 0.0020672 * t2 + 0.00000215 * t3);
+	double jde = NEW_MOON_EPOCH + SYNODIC_MONTH * k + 0.00015437 * t2 - 0.000000150 * t3
+		+ 0.00000000073 * t4;
+	double sum = 0;
+	int i;
+
+	for (i = 0; i < NUM_TERMS; i++)
+		sum += TERM_COEF[i] * e_pow[TERM_E[i]]
+			* sin(TERM_M[i] * m + TERM_MP[i] * mp + TERM_F[i] * f + TERM_OM[i] * om);
+	for (i = 0; i < NUM_PLANETARY; i++)
+		sum += PLANETARY_COEF[i]
+			* sin(radians(PLANETARY_BASE[i] + PLANETARY_RATE[i] * k - PLANETARY_T2[i] * t2));
+
+	return jde + sum;
+}
+
+/* absolute day with fraction, UT, of a molad given in parts since the epoch */
+static double molad_instant(const int64_t parts)
+{
+	/* the Hebrew day starts at 6 pm of the previous civil day */
+	return (double)parts / PARTS_PER_DAY - 0.25 - JERUSALEM_OFFSET;
+}
+
+int hc_compute_new_moons(int year, int month, const int count, hc_new_moon *out)
+{
+	hc_date d;
+	heb_time t;
+	int64_t parts;
+	int i;
+
+	if (out == NULL || count < 0 || year < 1 || year > HC_MAX_YEAR || month < 1 || month > 13
+			|| (month == 13 && !hc_heb_is_leap_year(year)))
+		return -1;
+
+	if (hc_compute_molad(year, month, HEBREW, &d, &t) != 0)
+		return -1;
+	parts = hc_heb_to_abs_date(d.year, d.month, d.day) * PARTS_PER_DAY + t.hour * 1080L + t.part;
+
+	for (i = 0; i < count; i++) {
+		const double molad = molad_instant(parts);
+		/* Julian day (UT) of the molad, and the lunation it belongs to */
+		const double jd_molad = molad + ABS_TO_JULIAN_DAY - 0.5;
+		const double k = floor((jd_molad - NEW_MOON_EPOCH) / SYNODIC_MONTH + 0.5);
+		const double jde = true_new_moon(k);
+		const double jd = jde - delta_t(2000 + (jde - 2451545.0) / 365.25) / 86400;
+
+		out[i].year = year;
+		out[i].month = month;
+		out[i].molad = molad;
+		out[i].conjunction = jd - ABS_TO_JULIAN_DAY + 0.5;
+		out[i].drift = (out[i].conjunction - molad) * 24;
+
+		parts += LUNATION_PARTS;
+		heb_next_month(&year, &month);
+	}
+	return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ Expansion of recurring events over a range of days.
+
+ The expansion walks month by month from the start of the range. Moving to the
+ next month only adds the length of the current one, and Hebrew years are
+ laid out once each (see heb_year_layout), so every occurrence costs a
+ constant amount of work regardless of how far the range extends.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stddef.h>
+
+/** Position of the walk: one month of the rule's calendar */
+typedef struct month_cursor_s {
+	hc_calendar_type calendar;
+	hc_cal_impl *impl;
+	int year;
+	int month;
+	int leap;
+	hc_abs_day start;       /* absolute day of the 1st of the month */
+	int length;
+	heb_year_layout layout; /* Hebrew only */
+	int index;              /* Hebrew only: chronological month in layout */
+} month_cursor;
+
+static void cursor_from_layout(month_cursor *c)
+{
+	c->year = c->layout.year;
+	c->leap = c->layout.leap;
+	c->month = c->layout.month[c->index];
+	c->start = c->layout.month_start[c->index];
+	c->length = c->layout.month_length[c->index];
+}
+
+/* position the cursor on the month containing the absolute day */
+static int cursor_init(month_cursor *c, const hc_calendar_type calendar, const hc_abs_day abs_date)
+{
+	hc_date d;
+
+	c->calendar = calendar;
+	c->impl = get_calendar(calendar);
+	if (c->impl == NULL || c->impl->compute_date(abs_date, &d) != 0)
+		return -1;
+
+	if (calendar == HEBREW) {
+		heb_year_layout_init(&c->layout, d.year);
+		c->index = 0;
+		while (c->index + 1 < c->layout.months && c->layout.month_start[c->index + 1] <= abs_date)
+			c->index++;
+		cursor_from_layout(c);
+	} else {
+		c->year = d.year;
+		c->month = d.month;
+		c->leap = c->impl->is_leap_year(d.year) ? 1 : 0;
+		c->start = abs_date - d.day + 1;
+		c->length = c->impl->month_length(d.year, d.month);
+	}
+	return 0;
+}
+
+static void cursor_next(month_cursor *c)
+{
+	if (c->calendar == HEBREW) {
+		if (++c->index == c->layout.months) {
+			heb_year_layout_next(&c->layout);
+			c->index = 0;
+		}
+		cursor_from_layout(c);
+	} else {
+		c->start += c->length;
+		if (++c->month > 12) {
+			c->month = 1;
+			c->year++;
+			c->leap = c->impl->is_leap_year(c->year) ? 1 : 0;
+		}
+		c->length = c->impl->month_length(c->year, c->month);
+	}
+}
+
+/* Month of the year in which a yearly rule falls, 0 if none this year.
+   Only the two Adars of the Hebrew calendar need any care. */
+static int yearly_month(const hc_rule *rule, const month_cursor *c)
+{
+	if (rule->calendar != HEBREW)
+		return rule->month;
+	if (c->leap && rule->month == 12 && rule->leap_policy == LATER_IF_MISSING)
+		return 13;
+	if (!c->leap && rule->month == 13)
+		return rule->leap_policy == SKIP_MISSING ? 0 : 12;
+	return rule->month;
+}
+
+/* Absolute day for the rule's day of the cursor's month, -1 if it is skipped */
+static hc_abs_day day_in_month(const hc_rule *rule, const month_cursor *c)
+{
+	if (rule->day <= c->length)
+		return c->start + rule->day - 1;
+	switch (rule->leap_policy) {
+	case EARLIER_IF_MISSING: return c->start + c->length - 1;
+	case LATER_IF_MISSING: return c->start + c->length;
+	default: return -1;
+	}
+}
+
+int hc_expand(const hc_rule *rule, const hc_abs_day from_abs, const hc_abs_day to_abs, hc_abs_day *out, const int max_out)
+{
+	month_cursor c;
+	int count = 0, prev_length;
+	hc_abs_day a;
+
+#define EMIT(x) do { \
+		if ((x) >= from_abs && (x) <= to_abs) { \
+			if (count == max_out) return count; \
+			out[count++] = (x); \
+		} \
+	} while (0)
+
+	if (rule == NULL || out == NULL || max_out < 0 || from_abs < 1 || to_abs < from_abs)
+		return -1;
+	if (rule->frequency == ROSH_CHODESH_RULE ? rule->calendar != HEBREW :
+			(rule->day < 1 || rule->day > 31))
+		return -1;
+	if (rule->frequency == YEARLY_RULE && (rule->month < 1 || rule->month > 13))
+		return -1;
+
+	/* start a day early: a month may place its occurrence on the next month's 1st */
+	if (cursor_init(&c, rule->calendar, from_abs > 1 ? from_abs - 1 : from_abs) != 0)
+		return -1;
+	prev_length = 29;
+
+	for (; c.start - 1 <= to_abs; prev_length = c.length, cursor_next(&c)) {
+		switch (rule->frequency) {
+		case YEARLY_RULE:
+			if (c.month != yearly_month(rule, &c))
+				break;
+			/* fall through */
+		case MONTHLY_RULE:
+			if ((a = day_in_month(rule, &c)) >= 0)
+				EMIT(a);
+			break;
+		case ROSH_CHODESH_RULE:
+			/* two days when the previous month has 30; none for Rosh Hashana */
+			if (c.month == 7)
+				break;
+			if (prev_length == 30)
+				EMIT(c.start - 1);
+			EMIT(c.start);
+			break;
+		default:
+			return -1;
+		}
+	}
+#undef EMIT
+	return count;
+}
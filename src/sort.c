@@ -0,0 +1,119 @@
+/**
+ Sorting and searching of collections of dates in any mix of calendars.
+
+ Each date is converted to its absolute day once. The (day, index) pairs are
+ then sorted with an LSD radix sort on the day, which is stable, so dates
+ falling on the same day keep their original order.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Bits of the key sorted in one pass */
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/* Key of a pair is kept in the upper half, original index in the lower */
+#define PAIR_INDEX(p) ((size_t)((p) & 0xffffffffu))
+
+/* One stable counting pass on the digit at given shift of the key */
+static void radix_pass(const uint64_t *src, uint64_t *dst, const size_t count, const int shift)
+{
+	size_t counts[RADIX_SIZE];
+	size_t i, sum = 0;
+
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < count; i++)
+		counts[(src[i] >> shift) & RADIX_MASK]++;
+	for (i = 0; i < RADIX_SIZE; i++) {
+		size_t c = counts[i];
+		counts[i] = sum;
+		sum += c;
+	}
+	for (i = 0; i < count; i++)
+		dst[counts[(src[i] >> shift) & RADIX_MASK]++] = src[i];
+}
+
+int hc_sort_dates(hc_date *dates, const size_t count, size_t *perm)
+{
+	uint64_t *src, *dst, *swap;
+	hc_date *copy;
+	hc_abs_day abs_date, min = 0, max = 0;
+	uint64_t range;
+	size_t i;
+	int shift;
+
+	if (count > 0xffffffffu)
+		return -1;
+	if (count == 0)
+		return 0;
+
+	src = malloc(count * sizeof(uint64_t));
+	dst = malloc(count * sizeof(uint64_t));
+	copy = malloc(count * sizeof(hc_date));
+	if (src == NULL || dst == NULL || copy == NULL)
+		goto fail;
+
+	/* extract keys, the only calendar computation done per date */
+	for (i = 0; i < count; i++) {
+		hc_cal_impl *impl = get_calendar(dates[i].calendar_type);
+		if (impl == NULL || !impl->check_date(dates[i].year, dates[i].month, dates[i].day))
+			goto fail;
+		abs_date = impl->abs_date(dates[i].year, dates[i].month, dates[i].day);
+		if (i == 0 || abs_date < min)
+			min = abs_date;
+		if (i == 0 || abs_date > max)
+			max = abs_date;
+		src[i] = (uint64_t)abs_date;
+	}
+	range = (uint64_t)(max - min);
+	if (range > 0xffffffffu)
+		goto fail;
+	for (i = 0; i < count; i++)
+		src[i] = ((src[i] - (uint64_t)min) << 32) | i;
+
+	/* only as many passes as the spread of days needs */
+	for (shift = 0; shift < 32 && (range >> shift) != 0; shift += RADIX_BITS) {
+		radix_pass(src, dst, count, 32 + shift);
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	memcpy(copy, dates, count * sizeof(hc_date));
+	for (i = 0; i < count; i++) {
+		dates[i] = copy[PAIR_INDEX(src[i])];
+		if (perm != NULL)
+			perm[i] = PAIR_INDEX(src[i]);
+	}
+	free(src);
+	free(dst);
+	free(copy);
+	return 0;
+
+fail:
+	free(src);
+	free(dst);
+	free(copy);
+	return -1;
+}
+
+size_t hc_lower_bound(const hc_date *dates, const size_t count, const hc_date *key)
+{
+	size_t lo = 0, hi = count;
+	const hc_abs_day key_abs = hc_get_abs_date(key);
+
+	if (key_abs < 0)
+		return (size_t)-1;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (hc_get_abs_date(dates + mid) < key_abs)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
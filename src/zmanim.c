@@ -0,0 +1,231 @@
+/**
+ Computation of zmanim (halachic times of day) from the position of the sun.
+
+ The sun is modelled with the low precision formulae of the Astronomical
+ Almanac (good to about a minute of time between 1800 and 2200 and degrading
+ slowly outside of that). Mean longitude and mean anomaly advance by a fixed
+ angle every day, so their sines and cosines are rotated from one day to the
+ next instead of being recomputed, and are reseeded now and then to keep
+ rounding errors from accumulating.
+ */
+#include "hconverter.h"
+#include "hc_internal.h"
+#include <math.h>
+#include <stddef.h>
+
+#define PI 3.14159265358979323846
+#define DEG (PI / 180.0)
+
+/** Julian day of the J2000.0 epoch, 2000-01-01 12:00 UT */
+#define J2000 2451545L
+
+/** Days after which the incremental rotation is recomputed exactly */
+#define RESEED_INTERVAL 64
+
+/* Altitude of the sun, in degrees, defining each zman */
+static const double SUNRISE_ALTITUDE = -0.833;
+static const double ALOT_ALTITUDE = -16.1;
+static const double TZEIS_ALTITUDE = -8.5;
+
+/** Eccentricity of Earth's orbit */
+static const double ECCENTRICITY = 0.016709;
+
+/* daily motion of mean longitude and mean anomaly, degrees */
+static const double L_RATE = 0.9856474;
+static const double G_RATE = 0.9856003;
+
+/** Position of the sun at noon UT of one day, as needed for zmanim */
+typedef struct sun_state_s {
+	double sin_dec;  /* sine of declination */
+	double eot;      /* equation of time, minutes */
+} sun_state;
+
+/** Incremental walk of the sun's mean elements from day to day */
+typedef struct sun_walker_s {
+	double n;                 /* days since J2000.0 */
+	double sin_l, cos_l;      /* mean longitude */
+	double sin_g, cos_g;      /* mean anomaly */
+	double sin_dl, cos_dl;    /* daily step of mean longitude */
+	double sin_dg, cos_dg;    /* daily step of mean anomaly */
+	double sin_eps, y;        /* obliquity: sin(eps), tan^2(eps/2) */
+	int steps;
+} sun_walker;
+
+/** Location dependent terms, computed once per location */
+typedef struct loc_terms_s {
+	double sin_lat, cos_lat;
+	double sin_rise_alt;      /* sunrise altitude corrected for elevation */
+	double sin_alot_alt;
+	double sin_tzeis_alt;
+	double day_offset;        /* local noon relative to noon UT, in days */
+	double noon_base;         /* local clock time of noon before equation of time */
+} loc_terms;
+
+static void walker_seek(sun_walker *w, const double n)
+{
+	const double l = (280.460 + L_RATE * n) * DEG;
+	const double g = (357.528 + G_RATE * n) * DEG;
+	const double eps = (23.439 - 0.0000004 * n) * DEG;
+	const double t = tan(eps / 2);
+
+	w->n = n;
+	w->sin_l = sin(l);
+	w->cos_l = cos(l);
+	w->sin_g = sin(g);
+	w->cos_g = cos(g);
+	w->sin_dl = sin(L_RATE * DEG);
+	w->cos_dl = cos(L_RATE * DEG);
+	w->sin_dg = sin(G_RATE * DEG);
+	w->cos_dg = cos(G_RATE * DEG);
+	w->sin_eps = sin(eps);
+	w->y = t * t;
+	w->steps = 0;
+}
+
+/* advance by one day: rotate the mean elements by their daily motion */
+static void walker_next(sun_walker *w)
+{
+	double s, c;
+
+	if (++w->steps == RESEED_INTERVAL) {
+		walker_seek(w, w->n + 1);
+		return;
+	}
+	w->n += 1;
+	s = w->sin_l * w->cos_dl + w->cos_l * w->sin_dl;
+	c = w->cos_l * w->cos_dl - w->sin_l * w->sin_dl;
+	w->sin_l = s;
+	w->cos_l = c;
+	s = w->sin_g * w->cos_dg + w->cos_g * w->sin_dg;
+	c = w->cos_g * w->cos_dg - w->sin_g * w->sin_dg;
+	w->sin_g = s;
+	w->cos_g = c;
+}
+
+static sun_state walker_state(const sun_walker *w)
+{
+	sun_state ret;
+	const double e = ECCENTRICITY;
+	const double y = w->y;
+	const double sin_2g = 2 * w->sin_g * w->cos_g;
+	const double sin_2l = 2 * w->sin_l * w->cos_l;
+	const double cos_2l = w->cos_l * w->cos_l - w->sin_l * w->sin_l;
+	const double sin_4l = 2 * sin_2l * cos_2l;
+
+	/* equation of center; it is small enough for a short series */
+	const double c = (1.915 * w->sin_g + 0.020 * sin_2g) * DEG;
+	const double c2 = c * c;
+	const double sin_c = c * (1 - c2 / 6);
+	const double cos_c = 1 - c2 / 2 + c2 * c2 / 24;
+	const double sin_lambda = w->sin_l * cos_c + w->cos_l * sin_c;
+
+	/* equation of time, Meeus (28.3), in radians */
+	const double eot = y * sin_2l - 2 * e * w->sin_g + 4 * e * y * w->sin_g * cos_2l
+		- 0.5 * y * y * sin_4l - 1.25 * e * e * sin_2g;
+
+	ret.sin_dec = w->sin_eps * sin_lambda;
+	ret.eot = eot / DEG * 4;
+	return ret;
+}
+
+static double abs_to_j2000(const hc_abs_day abs_date)
+{
+	return (double)(abs_date + ABS_TO_JULIAN_DAY - J2000);
+}
+
+static void loc_prepare(const hc_location *loc, loc_terms *lt)
+{
+	const double lat = loc->latitude * DEG;
+	double alt = SUNRISE_ALTITUDE;
+
+	if (loc->elevation > 0)
+		alt -= 2.076 * sqrt(loc->elevation) / 60;
+	lt->sin_lat = sin(lat);
+	lt->cos_lat = cos(lat);
+	lt->sin_rise_alt = sin(alt * DEG);
+	lt->sin_alot_alt = sin(ALOT_ALTITUDE * DEG);
+	lt->sin_tzeis_alt = sin(TZEIS_ALTITUDE * DEG);
+	lt->day_offset = -loc->longitude / 360;
+	lt->noon_base = 12 - loc->longitude / 15 + loc->time_zone;
+}
+
+/* Hour angle, in hours, at which the sun reaches the altitude with given sine.
+   NaN if it never does, which acos() takes care of. */
+static double hour_angle(const double sin_alt, const double sin_lat, const double cos_lat,
+		const double sin_dec, const double cos_dec)
+{
+	return acos((sin_alt - sin_lat * sin_dec) / (cos_lat * cos_dec)) / DEG / 15;
+}
+
+/* zmanim at a location; the sun is interpolated to local noon from the
+   states at noon UT of the previous, current and next days */
+static void loc_zmanim(const loc_terms *lt, const sun_state *prev, const sun_state *cur,
+		const sun_state *next, hc_zmanim *out)
+{
+	const double t = lt->day_offset / 2;
+	const double sin_dec = cur->sin_dec + t * (next->sin_dec - prev->sin_dec);
+	const double eot = cur->eot + t * (next->eot - prev->eot);
+	const double cos_dec = sqrt(1 - sin_dec * sin_dec);
+	const double noon = lt->noon_base - eot / 60;
+	double h;
+
+	h = hour_angle(lt->sin_rise_alt, lt->sin_lat, lt->cos_lat, sin_dec, cos_dec);
+	out->sunrise = noon - h;
+	out->sunset = noon + h;
+	out->shaah_zmanit = h / 6;
+	out->chatzot = noon;
+	out->alot = noon - hour_angle(lt->sin_alot_alt, lt->sin_lat, lt->cos_lat, sin_dec, cos_dec);
+	out->tzeis = noon + hour_angle(lt->sin_tzeis_alt, lt->sin_lat, lt->cos_lat, sin_dec, cos_dec);
+}
+
+int hc_zmanim_range(const hc_location *loc, const hc_abs_day from_abs, const hc_abs_day to_abs, hc_zmanim *out)
+{
+	sun_walker w;
+	sun_state prev, cur, next;
+	loc_terms lt;
+	hc_abs_day d;
+
+	if (loc == NULL || out == NULL || from_abs < 1 || to_abs < from_abs)
+		return -1;
+
+	loc_prepare(loc, &lt);
+	walker_seek(&w, abs_to_j2000(from_abs - 1));
+	prev = walker_state(&w);
+	walker_next(&w);
+	cur = walker_state(&w);
+
+	for (d = from_abs; d <= to_abs; d++) {
+		walker_next(&w);
+		next = walker_state(&w);
+		loc_zmanim(&lt, &prev, &cur, &next, out + (d - from_abs));
+		prev = cur;
+		cur = next;
+	}
+	return 0;
+}
+
+int hc_zmanim_locations(const hc_location *locs, const int count, const hc_abs_day abs_date, hc_zmanim *out)
+{
+	sun_walker w;
+	sun_state prev, cur, next;
+	loc_terms lt;
+	int i;
+
+	if (locs == NULL || out == NULL || count < 0 || abs_date < 1)
+		return -1;
+
+	walker_seek(&w, abs_to_j2000(abs_date - 1));
+	prev = walker_state(&w);
+	walker_next(&w);
+	cur = walker_state(&w);
+	walker_next(&w);
+	next = walker_state(&w);
+
+	/* the sun is shared by all locations; each still takes its own sines and
+	   arc cosines, and NaN for a sun that does not reach an altitude */
+	for (i = 0; i < count; i++) {
+		loc_prepare(locs + i, &lt);
+		loc_zmanim(&lt, &prev, &cur, &next, out + i);
+	}
+	return 0;
+}
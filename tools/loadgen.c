@@ -0,0 +1,402 @@
+/**
+ Load generator for the converter engine and the hconverter command line tool.
+
+ Commands in the hconverter command language are either read from a log, one
+ per line, or synthesized from weighted distributions of commands, calendars
+ and years. They are then replayed from a number of threads, optionally paced
+ to a target total rate, either in process through run_cmd() or by running
+ the hconverter binary once per command. Throughput and latency percentiles
+ are reported per command type.
+
+ Latency is measured from the time a command was due to be sent, not from
+ when it actually was, so a server falling behind the target rate shows up in
+ the tail rather than being hidden by it.
+
+ Usage: hc_loadgen [options]
+   -f file     replay commands from file instead of synthesizing them
+   -n count    number of commands to synthesize (default 100000)
+   -t threads  number of threads (default: number of processors)
+   -r rate     target total commands per second, 0 for as fast as possible
+   -b binary   run this hconverter binary per command instead of the library
+   -k          turn on the result cache of each thread (in process only)
+   -w weights  command mix, e.g. convert:60,molad:10,keviut:10,type:5,isleap:5,absolute:5,format:5
+   -c weights  calendar mix, e.g. g:60,h:30,j:10
+   -y from:to  range of Gregorian years; Hebrew years are shifted by 3760
+   -s seed     random seed
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "hconverter.h"
+#include "hc_internal.h"
+
+#define MAX_LINE 256
+#define NUM_TYPES 8
+
+extern char **environ;
+
+/** Command types reported on, by canonical name; unknown commands go last */
+static const char *const TYPE_NAMES[NUM_TYPES] = {
+	"convert", "molad", "keviut", "type", "isleap", "absolute", "format", "(invalid)"
+};
+
+typedef struct command_s {
+	char line[MAX_LINE];
+	int type;
+} command;
+
+typedef struct worker_s {
+	int id;
+	pthread_t tid;
+	long *latencies[NUM_TYPES];   /* nanoseconds */
+	long counts[NUM_TYPES];
+	long errors[NUM_TYPES];
+	hc_cache_stats cache;
+} worker;
+
+static command *commands;
+static long num_commands;
+static int num_threads;
+static double rate;
+static const char *binary;
+static int use_cache;
+static struct timespec start_time;
+
+static int weights_cmd[NUM_TYPES - 1] = { 60, 10, 10, 5, 5, 5, 5 };
+static int weights_cal[3] = { 60, 30, 10 };   /* g, h, j */
+static int year_from = 1900, year_to = 2100;
+
+static long now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/* type of a command line; -1 for quit */
+static int type_of(const char *line)
+{
+	char buf[MAX_LINE], *tokens[CMD_TOKENS];
+	const char *name;
+	int i;
+
+	strncpy(buf, line, MAX_LINE - 1);
+	buf[MAX_LINE - 1] = '\0';
+	cmd_tokenize(buf, tokens);
+	name = cmd_name(tokens[0]);
+	if (name != NULL && strcmp(name, "quit") == 0)
+		return -1;
+	for (i = 0; name != NULL && i < NUM_TYPES - 1; i++)
+		if (strcmp(name, TYPE_NAMES[i]) == 0)
+			return i;
+	return NUM_TYPES - 1;
+}
+
+static int pick(const int *weights, const int n)
+{
+	int i, total = 0, r;
+	for (i = 0; i < n; i++)
+		total += weights[i];
+	r = rand() % total;
+	for (i = 0; r >= weights[i]; i++)
+		r -= weights[i];
+	return i;
+}
+
+/* synthesize one command line of given type */
+static void synthesize(char *line, const int type)
+{
+	static const char cal_letter[3] = { 'g', 'h', 'j' };
+	const int cal = pick(weights_cal, 3), cal2 = pick(weights_cal, 3);
+	const int greg_year = year_from + rand() % (year_to - year_from + 1);
+	const int heb_year = greg_year + 3760;
+	const int year = cal_letter[cal] == 'h' ? heb_year : greg_year;
+	const int month = 1 + rand() % 12, day = 1 + rand() % 28;
+
+	switch (type) {
+	case 0: sprintf(line, "convert %c %c %d %d %d", cal_letter[cal], cal_letter[cal2], year, month, day); break;
+	case 1: sprintf(line, "molad %c %d %d", cal_letter[cal], heb_year, month); break;
+	case 2: sprintf(line, "keviut %d", heb_year); break;
+	case 3: sprintf(line, "type %d", heb_year); break;
+	case 4: sprintf(line, "isleap %c %d", cal_letter[cal], year); break;
+	case 5: sprintf(line, "absolute %c %d %d %d", cal_letter[cal], year, month, day); break;
+	default: sprintf(line, "format %c %d %d %d", cal_letter[cal], year, month, day); break;
+	}
+}
+
+/* parse "name:weight,..." into weights indexed by position of name in names */
+static int parse_weights(const char *spec, const char *const *names, const int n, int *weights)
+{
+	char buf[MAX_LINE], *save = NULL, *item;
+	int i;
+
+	memset(weights, 0, n * sizeof(int));
+	strncpy(buf, spec, MAX_LINE - 1);
+	buf[MAX_LINE - 1] = '\0';
+	for (item = strtok_r(buf, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+		char *colon = strchr(item, ':');
+		if (colon == NULL)
+			return -1;
+		*colon = '\0';
+		for (i = 0; i < n && strcmp(item, names[i]) != 0; i++)
+			;
+		if (i == n)
+			return -1;
+		weights[i] = atoi(colon + 1);
+	}
+	for (i = 0; i < n; i++)
+		if (weights[i] > 0)
+			return 0;
+	return -1;
+}
+
+static int load_file(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[MAX_LINE];
+	long cap = 1024;
+
+	if (f == NULL)
+		return -1;
+	commands = malloc(cap * sizeof(command));
+	num_commands = 0;
+	while (commands != NULL && fgets(line, sizeof(line), f) != NULL) {
+		line[strcspn(line, "\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#')
+			continue;
+		if (num_commands == cap) {
+			command *more = realloc(commands, 2 * cap * sizeof(command));
+			if (more == NULL) {
+				free(commands);
+				commands = NULL;
+				break;
+			}
+			commands = more;
+			cap *= 2;
+		}
+		/* a recorded quit ends an interactive session; nothing to measure */
+		if ((commands[num_commands].type = type_of(line)) < 0)
+			continue;
+		strcpy(commands[num_commands].line, line);
+		num_commands++;
+	}
+	fclose(f);
+	return commands != NULL ? 0 : -1;
+}
+
+/* run a command by spawning the binary with the command as arguments */
+static int run_binary(char **tokens)
+{
+	char *argv[CMD_TOKENS + 2];
+	posix_spawn_file_actions_t actions;
+	pid_t pid;
+	int i, status;
+
+	argv[0] = (char *)binary;
+	for (i = 0; i < CMD_TOKENS; i++)
+		argv[i + 1] = tokens[i];
+	argv[CMD_TOKENS + 1] = NULL;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+	if (posix_spawn(&pid, binary, &actions, NULL, argv, environ) != 0) {
+		posix_spawn_file_actions_destroy(&actions);
+		return -1;
+	}
+	posix_spawn_file_actions_destroy(&actions);
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return -1;
+	return 0;
+}
+
+static void *run_worker(void *arg)
+{
+	worker *w = arg;
+	FILE *devnull = fopen("/dev/null", "w");
+	const long t0 = start_time.tv_sec * 1000000000L + start_time.tv_nsec;
+	/* each worker sends every num_threads-th command; commands are due evenly spaced */
+	const double interval = rate > 0 ? 1e9 / rate : 0;
+	char buf[MAX_LINE], *tokens[CMD_TOKENS];
+	long i;
+
+	hc_cache_enable(use_cache);
+	for (i = w->id; i < num_commands; i += num_threads) {
+		const command *c = &commands[i];
+		long due = t0 + (long)(i * interval), t, done;
+		int ret;
+
+		if (interval > 0) {
+			while ((t = now_ns()) < due) {
+				struct timespec ts = { (due - t) / 1000000000L, (due - t) % 1000000000L };
+				nanosleep(&ts, NULL);
+			}
+		} else {
+			due = now_ns();
+		}
+		strcpy(buf, c->line);
+		cmd_tokenize(buf, tokens);
+		ret = binary ? run_binary(tokens) : run_cmd(tokens, devnull);
+		done = now_ns();
+		w->latencies[c->type][w->counts[c->type]++] = done - due;
+		if (ret != 0)
+			w->errors[c->type]++;
+	}
+	hc_cache_get_stats(&w->cache);
+	fclose(devnull);
+	return NULL;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+	const long x = *(const long *)a, y = *(const long *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(const long *sorted, const long n, const double p)
+{
+	long i = (long)(p / 100 * (n - 1) + 0.5);
+	return sorted[i] / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+	const char *file = NULL;
+	long per_type[NUM_TYPES] = { 0 }, i;
+	worker *workers;
+	double elapsed;
+	int opt, k, j;
+	unsigned seed = 1;
+
+	num_commands = 100000;
+	num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	while ((opt = getopt(argc, argv, "f:n:t:r:b:w:c:y:s:k")) != -1) {
+		switch (opt) {
+		case 'f': file = optarg; break;
+		case 'n': num_commands = atol(optarg); break;
+		case 't': num_threads = atoi(optarg); break;
+		case 'r': rate = atof(optarg); break;
+		case 'b': binary = optarg; break;
+		case 'k': use_cache = 1; break;
+		case 's': seed = (unsigned)atol(optarg); break;
+		case 'y':
+			if (sscanf(optarg, "%d:%d", &year_from, &year_to) != 2 || year_from < 1 || year_to < year_from) {
+				fprintf(stderr, "bad year range %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'w':
+			if (parse_weights(optarg, TYPE_NAMES, NUM_TYPES - 1, weights_cmd) != 0) {
+				fprintf(stderr, "bad command weights %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'c': {
+			static const char *const cal_names[3] = { "g", "h", "j" };
+			if (parse_weights(optarg, cal_names, 3, weights_cal) != 0) {
+				fprintf(stderr, "bad calendar weights %s\n", optarg);
+				return 2;
+			}
+			break;
+		}
+		default:
+			fprintf(stderr, "usage: %s [-f file | -n count -w weights -c weights -y from:to -s seed]"
+				" [-t threads] [-r rate] [-b binary] [-k]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (num_threads < 1)
+		num_threads = 1;
+
+	if (file != NULL) {
+		if (load_file(file) != 0) {
+			perror(file);
+			return 1;
+		}
+	} else {
+		srand(seed);
+		commands = malloc((num_commands ? num_commands : 1) * sizeof(command));
+		if (commands == NULL) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		for (i = 0; i < num_commands; i++) {
+			commands[i].type = pick(weights_cmd, NUM_TYPES - 1);
+			synthesize(commands[i].line, commands[i].type);
+		}
+	}
+	for (i = 0; i < num_commands; i++)
+		per_type[commands[i].type]++;
+
+	workers = calloc(num_threads, sizeof(worker));
+	if (workers == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (j = 0; j < num_threads; j++) {
+		/* a worker gets at most every num_threads-th command of each type */
+		const long share = num_commands / num_threads + 1;
+		workers[j].id = j;
+		for (k = 0; k < NUM_TYPES; k++) {
+			const long n = per_type[k] < share ? per_type[k] : share;
+			workers[j].latencies[k] = malloc((n ? n : 1) * sizeof(long));
+			if (workers[j].latencies[k] == NULL) {
+				fprintf(stderr, "out of memory\n");
+				return 1;
+			}
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	for (j = 0; j < num_threads; j++)
+		pthread_create(&workers[j].tid, NULL, run_worker, &workers[j]);
+	for (j = 0; j < num_threads; j++)
+		pthread_join(workers[j].tid, NULL);
+	elapsed = (now_ns() - (start_time.tv_sec * 1000000000L + start_time.tv_nsec)) / 1e9;
+
+	printf("%ld commands on %d threads in %.3f s: %.0f commands/s (%s)\n", num_commands, num_threads,
+		elapsed, num_commands / elapsed, binary ? binary : "library");
+	printf("%-10s %10s %8s %12s %10s %10s %10s %10s %10s\n", "command", "count", "errors",
+		"per second", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+	for (k = 0; k < NUM_TYPES; k++) {
+		long n = 0, errors = 0, *all;
+		if (per_type[k] == 0)
+			continue;
+		all = malloc(per_type[k] * sizeof(long));
+		if (all == NULL) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		for (j = 0; j < num_threads; j++) {
+			memcpy(all + n, workers[j].latencies[k], workers[j].counts[k] * sizeof(long));
+			n += workers[j].counts[k];
+			errors += workers[j].errors[k];
+		}
+		qsort(all, n, sizeof(long), compare_long);
+		printf("%-10s %10ld %8ld %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n", TYPE_NAMES[k], n, errors,
+			n / elapsed, percentile(all, n, 50), percentile(all, n, 90), percentile(all, n, 99),
+			percentile(all, n, 99.9), all[n - 1] / 1e3);
+		free(all);
+	}
+	if (use_cache && binary == NULL) {
+		hc_cache_stats total = { 0, 0, 0 };
+		for (j = 0; j < num_threads; j++) {
+			total.lookups += workers[j].cache.lookups;
+			total.hits += workers[j].cache.hits;
+			total.evictions += workers[j].cache.evictions;
+		}
+		printf("cache: %lu lookups, %lu hits (%.1f%%), %lu evictions\n", total.lookups, total.hits,
+			total.lookups ? 100.0 * total.hits / total.lookups : 0.0, total.evictions);
+	}
+
+	for (j = 0; j < num_threads; j++)
+		for (k = 0; k < NUM_TYPES; k++)
+			free(workers[j].latencies[k]);
+	free(workers);
+	free(commands);
+	return 0;
+}
@@ -0,0 +1,1355 @@
+/**
+ Exhaustive verification of the calendar arithmetic.
+
+ Every absolute day of the range is converted into every calendar and back,
+ through the generic entry points as well as the direct ones of hc_direct.h,
+ and the results are checked against each other and against invariants that
+ do not depend on the code under test: weekdays advance by one each day,
+ month lengths add up, Gregorian leap years follow the 4/100/400 rule, Islamic
+ ones the 30 year cycle, ISO week years start in the week of 4 January, Hebrew
+ years have one of the 14 possible keviut, and consecutive molads are one
+ mean lunation apart. The record of hc_date_info is compared, field by
+ field, with the results of the separate calls.
+
+ Around that, the extremes of the domain are checked: days and years just
+ inside the limits convert, those outside are rejected, random days from the
+ whole domain convert back and forth, and the time a conversion takes does
+ not grow with the size of the day. The columnar codec is run over the
+ range, and over a synthetic feed of event dates, and the result cache is
+ compared with the functions it caches. Zmanim are checked against almanac
+ times, and their two entry points against each other. Recurring events are
+ expanded and compared with the rules read day by day, and business days are
+ counted and added up against the calendar read the same way. Daf Yomi pages
+ are checked against known ones and from day to day, the keviut index
+ against the keviut of each year, and iCalendar output is checked for line
+ folding and escaping on a fixed feed.
+
+ The range is split into one contiguous chunk per processor.
+
+ Usage: hc_verify [first_abs_day [last_abs_day]]
+ */
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include "hconverter.h"
+#include "hc_internal.h"
+#include "hc_direct.h"
+
+/** Default end of range: Rosh Hashana of Hebrew year 10000 */
+#define DEFAULT_LAST_HEB_YEAR 10000
+
+/** Failures reported per check before going quiet */
+#define MAX_REPORTS 5
+
+/** Parts (1/1080 hour) in a mean lunation: 29d 12h 793p */
+#define LUNATION_PARTS ((29L * 24 + 12) * 1080 + 793)
+
+typedef enum check_id {
+	ROUND_TRIP, CROSS_CALENDAR, DIRECT_PATH, VALIDITY, WEEKDAY,
+	MONTH_LENGTH, YEAR_LENGTH, KEVIUT, LAYOUT, MOLAD, INFO, NUM_CHECKS
+} check_id;
+
+static const char *check_names[NUM_CHECKS] = {
+	"round trip", "cross calendar", "direct path", "validity", "weekday",
+	"month length", "year length", "keviut", "year layout", "molad", "date info"
+};
+
+typedef struct chunk_s {
+	hc_abs_day first;
+	hc_abs_day last;
+	long failures[NUM_CHECKS];
+	long checked;
+} chunk;
+
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+static long reported[NUM_CHECKS];
+
+/* the first DIRECT_CALENDARS have direct conversions in hc_direct.h */
+#define NUM_CALENDARS 5
+#define DIRECT_CALENDARS 3
+static const hc_calendar_type calendars[NUM_CALENDARS] = { GREGORIAN, JULIAN, HEBREW, ISLAMIC, ISO_WEEK };
+
+static void fail(chunk *c, const check_id id, const hc_abs_day abs_date, const char *what)
+{
+	c->failures[id]++;
+	pthread_mutex_lock(&report_lock);
+	if (reported[id]++ < MAX_REPORTS)
+		printf("FAIL %-14s abs %lld: %s\n", check_names[id], (long long)abs_date, what);
+	pthread_mutex_unlock(&report_lock);
+}
+
+static int same_date(const hc_date *a, const hc_date *b)
+{
+	return a->calendar_type == b->calendar_type && a->year == b->year
+		&& a->month == b->month && a->day == b->day;
+}
+
+static hc_abs_day first_abs(const hc_calendar_type cal)
+{
+	switch (cal) {
+	case GREGORIAN: return HC_COMMON_BEGINNING + 1;
+	case JULIAN: return HC_JULIAN_BEGINNING + 1;
+	case ISLAMIC: return ISLAMIC_BEGINNING;
+	case ISO_WEEK: return HC_COMMON_BEGINNING + 1;
+	default: return 2;
+	}
+}
+
+static int greg_leap_reference(const int year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/* leap years are the 2nd, 5th, 7th, 10th, 13th, 16th, 18th, 21st, 24th, 26th
+   and 29th of each 30 year cycle */
+static int islamic_leap_reference(const int year)
+{
+	static const int leap[] = { 2, 5, 7, 10, 13, 16, 18, 21, 24, 26, 29 };
+	size_t i;
+	for (i = 0; i < sizeof(leap) / sizeof(leap[0]); i++) {
+		if ((year - 1) % 30 + 1 == leap[i])
+			return 1;
+	}
+	return 0;
+}
+
+/* direct conversion between a pair of calendars, as generated in hc_direct.h */
+static int direct_convert(hc_date *date, const hc_calendar_type to)
+{
+	switch (date->calendar_type) {
+	case GREGORIAN:
+		return to == HEBREW ? hc_greg_to_heb(date) : hc_greg_to_jul(date);
+	case JULIAN:
+		return to == HEBREW ? hc_jul_to_heb(date) : hc_jul_to_greg(date);
+	case HEBREW:
+		return to == GREGORIAN ? hc_heb_to_greg(date) : hc_heb_to_jul(date);
+	default:
+		return -1;
+	}
+}
+
+/* molad as a count of parts since the absolute day epoch */
+static int64_t molad_parts(const int year, const int month)
+{
+	hc_date d;
+	heb_time t;
+	hc_compute_molad(year, month, HEBREW, &d, &t);
+	return (hc_heb_to_abs_date(d.year, d.month, d.day) * 24 + t.hour) * 1080 + t.part;
+}
+
+/* checks done once per Hebrew year, on its Rosh Hashana */
+static void check_heb_year(chunk *c, const hc_abs_day abs_date, const int year)
+{
+	/* the 14 possible keviut as (Rosh Hashana weekday, ck, leap) */
+	static const int valid[14][3] = {
+		{MONDAY, 0, 0}, {MONDAY, 2, 0}, {TUESDAY, 1, 0}, {THURSDAY, 1, 0},
+		{THURSDAY, 2, 0}, {SATURDAY, 0, 0}, {SATURDAY, 2, 0},
+		{MONDAY, 0, 1}, {MONDAY, 2, 1}, {TUESDAY, 1, 1}, {THURSDAY, 0, 1},
+		{THURSDAY, 2, 1}, {SATURDAY, 0, 1}, {SATURDAY, 2, 1}
+	};
+	heb_year_layout layout;
+	int rh, pesach, ck, leap, i, found = 0;
+	hc_abs_day len, expect;
+	int64_t m0, m1;
+	hc_date d;
+
+	hc_compute_keviut(year, &rh, &pesach, &ck, &leap);
+	if (rh != (abs_date - 1) % 7)
+		fail(c, KEVIUT, abs_date, "Rosh Hashana weekday");
+	if (ck != (int)hc_get_heb_year_type(year) || leap != hc_is_leap_year(year, HEBREW))
+		fail(c, KEVIUT, abs_date, "year type or leap");
+	for (i = 0; i < 14; i++)
+		found |= valid[i][0] == rh && valid[i][1] == ck && valid[i][2] == leap;
+	if (!found)
+		fail(c, KEVIUT, abs_date, "impossible keviut");
+	set_hc_date(&d, year, 1, 15, HEBREW);
+	if (pesach != (int)hc_get_day_of_week(&d))
+		fail(c, KEVIUT, abs_date, "Pesach weekday");
+
+	heb_year_layout_init(&layout, year);
+	len = layout.next_rosh_hashana - layout.rosh_hashana;
+	expect = 353 + ck + 30 * leap;
+	if (layout.rosh_hashana != abs_date || len != expect)
+		fail(c, YEAR_LENGTH, abs_date, "Hebrew year length");
+	for (i = 0; i < layout.months; i++) {
+		if (layout.month_length[i] != hc_get_month_length(year, layout.month[i], HEBREW)
+				|| layout.month_start[i] != hc_heb_to_abs_date(year, layout.month[i], 1))
+			fail(c, LAYOUT, abs_date, "month start or length");
+	}
+
+	/* molad of Tishrei falls on Rosh Hashana or up to 2 days before, and
+	   molads of consecutive months are one lunation apart */
+	m0 = molad_parts(year, 7);
+	if (m0 >= (abs_date + 1) * 24 * 1080 || m0 < (abs_date - 2) * 24 * 1080)
+		fail(c, MOLAD, abs_date, "molad of Tishrei too far from Rosh Hashana");
+	for (i = 1; i < layout.months; i++) {
+		m1 = molad_parts(year, layout.month[i]);
+		if (m1 - m0 != LUNATION_PARTS)
+			fail(c, MOLAD, abs_date, "molads not one lunation apart");
+		m0 = m1;
+	}
+}
+
+/* checks done once per month of a calendar, on its first day */
+static void check_month(chunk *c, const hc_abs_day abs_date, const hc_date *date)
+{
+	const hc_calendar_type cal = date->calendar_type;
+	const int len = hc_get_month_length(date->year, date->month, cal);
+	hc_date last, next, bad;
+
+	if (hc_set_abs_date(&last, abs_date + len - 1, cal) != 0 || last.day != len
+			|| last.month != date->month
+			|| hc_set_abs_date(&next, abs_date + len, cal) != 0 || next.day != 1) {
+		fail(c, MONTH_LENGTH, abs_date, "month length disagrees with conversion");
+		return;
+	}
+	set_hc_date(&bad, date->year, date->month, len + 1, cal);
+	if (hc_check(&bad))
+		fail(c, VALIDITY, abs_date, "day past end of month accepted");
+	set_hc_date(&bad, date->year, date->month, 0, cal);
+	if (hc_check(&bad))
+		fail(c, VALIDITY, abs_date, "day 0 accepted");
+
+	if (cal == GREGORIAN && date->month == 1) {
+		const hc_abs_day year_len = hc_get_abs_date(&(hc_date){GREGORIAN, date->year + 1, 1, 1}) - abs_date;
+		if (year_len != 365 + greg_leap_reference(date->year)
+				|| hc_is_leap_year(date->year, GREGORIAN) != greg_leap_reference(date->year))
+			fail(c, YEAR_LENGTH, abs_date, "Gregorian leap year");
+	}
+	if (cal == JULIAN && date->month == 1) {
+		const hc_abs_day year_len = hc_get_abs_date(&(hc_date){JULIAN, date->year + 1, 1, 1}) - abs_date;
+		if (year_len != 365 + (date->year % 4 == 0))
+			fail(c, YEAR_LENGTH, abs_date, "Julian leap year");
+	}
+	if (cal == ISLAMIC && date->month == 1) {
+		const hc_abs_day year_len = hc_get_abs_date(&(hc_date){ISLAMIC, date->year + 1, 1, 1}) - abs_date;
+		if (year_len != 354 + hc_is_leap_year(date->year, ISLAMIC)
+				|| hc_is_leap_year(date->year, ISLAMIC) != islamic_leap_reference(date->year))
+			fail(c, YEAR_LENGTH, abs_date, "Islamic leap year");
+	}
+	if (cal == ISO_WEEK && date->month == 1) {
+		const hc_abs_day year_len = hc_get_abs_date(&(hc_date){ISO_WEEK, date->year + 1, 1, 1}) - abs_date;
+		hc_date g;
+		if (year_len != 364 + 7 * hc_is_leap_year(date->year, ISO_WEEK) || date->day != 1
+				|| hc_set_abs_date(&g, abs_date + 3, GREGORIAN) != 0 || g.year != date->year
+				|| g.month != 1 || g.day > 7)
+			fail(c, YEAR_LENGTH, abs_date, "ISO week year");
+	}
+	if (cal == HEBREW && date->month == 7)
+		check_heb_year(c, abs_date, date->year);
+}
+
+/* hc_date_info, from a date of each calendar, against the separate calls */
+static void check_info(chunk *c, const hc_abs_day abs_date, const hc_date *dates)
+{
+	hc_date greg, jul, heb, molad;
+	heb_time t;
+	hc_info info;
+	int rh, pesach, ck, leap, i;
+
+	if (abs_date < first_abs(HEBREW))
+		return;
+	greg.calendar_type = jul.calendar_type = molad.calendar_type = NONE;
+	hc_set_abs_date(&greg, abs_date, GREGORIAN);
+	hc_set_abs_date(&jul, abs_date, JULIAN);
+	hc_set_abs_date(&heb, abs_date, HEBREW);
+	hc_compute_keviut(heb.year, &rh, &pesach, &ck, &leap);
+	if (hc_compute_molad(heb.year, heb.month, GREGORIAN, &molad, &t) != 0)
+		molad.calendar_type = NONE;
+
+	for (i = 0; i < NUM_CALENDARS; i++) {
+		if (dates[i].calendar_type == NONE)
+			continue;
+		if (hc_date_info(&dates[i], &info) != 0) {
+			fail(c, INFO, abs_date, "hc_date_info failed");
+			continue;
+		}
+		if (info.abs_date != abs_date || !same_date(&info.hebrew, &heb)
+				|| info.gregorian.calendar_type != greg.calendar_type
+				|| (greg.calendar_type != NONE && !same_date(&info.gregorian, &greg))
+				|| info.julian.calendar_type != jul.calendar_type
+				|| (jul.calendar_type != NONE && !same_date(&info.julian, &jul))
+				|| (int)info.day_of_week != (abs_date - 1) % 7)
+			fail(c, INFO, abs_date, "conversions");
+		if ((int)info.year_type != ck || info.leap != leap || info.rosh_hashana_dow != rh
+				|| info.pesach_dow != pesach)
+			fail(c, INFO, abs_date, "keviut");
+		if (info.molad.calendar_type != molad.calendar_type
+				|| (molad.calendar_type != NONE && (!same_date(&info.molad, &molad)
+					|| info.molad_time.hour != t.hour || info.molad_time.part != t.part)))
+			fail(c, INFO, abs_date, "molad");
+	}
+}
+
+static void check_day(chunk *c, const hc_abs_day abs_date, int *prev_dow)
+{
+	hc_date dates[NUM_CALENDARS], d;
+	int i, j, dow = -1;
+
+	for (i = 0; i < NUM_CALENDARS; i++) {
+		hc_calendar_type cal = calendars[i];
+		dates[i].calendar_type = NONE;
+		if (abs_date < first_abs(cal))
+			continue;
+		if (hc_set_abs_date(&dates[i], abs_date, cal) != 0) {
+			fail(c, ROUND_TRIP, abs_date, "cannot compute date");
+			continue;
+		}
+		if (!hc_check(&dates[i]))
+			fail(c, VALIDITY, abs_date, "computed date is invalid");
+		if (hc_get_abs_date(&dates[i]) != abs_date)
+			fail(c, ROUND_TRIP, abs_date, "date does not map back to its day");
+		if (dow < 0)
+			dow = hc_get_day_of_week(&dates[i]);
+		else if ((int)hc_get_day_of_week(&dates[i]) != dow)
+			fail(c, WEEKDAY, abs_date, "calendars disagree on weekday");
+		if (dates[i].day == 1)
+			check_month(c, abs_date, &dates[i]);
+	}
+
+	for (i = 0; i < NUM_CALENDARS; i++) {
+		if (dates[i].calendar_type == NONE)
+			continue;
+		for (j = 0; j < NUM_CALENDARS; j++) {
+			if (i == j || dates[j].calendar_type == NONE)
+				continue;
+			d = dates[i];
+			if (hc_convert(&d, calendars[j]) != 0 || !same_date(&d, &dates[j]))
+				fail(c, CROSS_CALENDAR, abs_date, "hc_convert");
+			if (i >= DIRECT_CALENDARS || j >= DIRECT_CALENDARS)
+				continue;
+			d = dates[i];
+			if (direct_convert(&d, calendars[j]) != 0 || !same_date(&d, &dates[j]))
+				fail(c, DIRECT_PATH, abs_date, "direct conversion");
+		}
+	}
+
+	check_info(c, abs_date, dates);
+
+	if (dow != (abs_date - 1) % 7 || (*prev_dow >= 0 && dow != (*prev_dow + 1) % 7))
+		fail(c, WEEKDAY, abs_date, "weekday does not advance by one");
+	*prev_dow = dow;
+	c->checked++;
+}
+
+static void *run_chunk(void *arg)
+{
+	chunk *c = arg;
+	int prev_dow = -1;
+	hc_abs_day a;
+
+	for (a = c->first; a <= c->last; a++)
+		check_day(c, a, &prev_dow);
+	return NULL;
+}
+
+/* spot checks against dates known from elsewhere */
+static long check_anchors(void)
+{
+	static const struct { hc_date from; hc_date to; } anchors[] = {
+		{ {JULIAN, 1582, 10, 5}, {GREGORIAN, 1582, 10, 15} },
+		{ {GREGORIAN, 1, 1, 1}, {JULIAN, 1, 1, 3} },
+		{ {GREGORIAN, 2024, 6, 21}, {HEBREW, 5784, 3, 15} },
+		{ {GREGORIAN, 2023, 6, 21}, {HEBREW, 5783, 4, 2} },
+		{ {HEBREW, 5785, 7, 1}, {GREGORIAN, 2024, 10, 3} },
+		{ {ISLAMIC, 1, 1, 1}, {JULIAN, 622, 7, 16} },
+		{ {GREGORIAN, 2008, 12, 29}, {ISO_WEEK, 2009, 1, 1} },
+		{ {GREGORIAN, 2021, 1, 3}, {ISO_WEEK, 2020, 53, 7} },
+	};
+	static const struct { hc_date date; int flags; const char *text; } formats[] = {
+		{ {HEBREW, 5784, 1, 15}, FORMAT_HEBREW_LETTERS, "ט״ו בניסן תשפ״ד" },
+		{ {HEBREW, 5784, 1, 15}, FORMAT_THOUSANDS, "ט״ו בניסן ה׳תשפ״ד" },
+		{ {HEBREW, 5000, 7, 1}, FORMAT_HEBREW_LETTERS, "א׳ בתשרי ה׳" },
+		{ {HEBREW, 5000, 7, 1}, FORMAT_THOUSANDS, "א׳ בתשרי ה׳" },
+		{ {HEBREW, 5000, 7, 1}, FORMAT_TRANSLITERATED, "1 Tishrei 5000" },
+		{ {HEBREW, 999784, 1, 15}, FORMAT_THOUSANDS, "ט״ו בניסן תתקצ״טתשפ״ד" },
+		{ {HEBREW, 1234567, 7, 1}, FORMAT_HEBREW_LETTERS, "א׳ בתשרי תקס״ז" },
+		/* no letters for the thousands: NULL for an error */
+		{ {HEBREW, 1234567, 7, 1}, FORMAT_THOUSANDS, NULL },
+		{ {HEBREW, 2000000, 7, 1}, FORMAT_HEBREW_LETTERS, NULL },
+	};
+	long failures = 0;
+	size_t i;
+
+	for (i = 0; i < sizeof(anchors) / sizeof(anchors[0]); i++) {
+		hc_date d = anchors[i].from;
+		if (hc_convert(&d, anchors[i].to.calendar_type) != 0 || !same_date(&d, &anchors[i].to)) {
+			printf("FAIL anchor %d-%d-%d -> %d-%d-%d\n", anchors[i].from.year, anchors[i].from.month,
+				anchors[i].from.day, anchors[i].to.year, anchors[i].to.month, anchors[i].to.day);
+			failures++;
+		}
+	}
+	if (hc_get_day_of_week(&(hc_date){GREGORIAN, 2024, 6, 21}) != FRIDAY) {
+		printf("FAIL anchor weekday of 2024-06-21\n");
+		failures++;
+	}
+	{
+		/* the conjunction of the solar eclipse of 8 April 2024 was at 18:21 UT */
+		hc_new_moon m;
+		const double at = hc_get_abs_date(&(hc_date){GREGORIAN, 2024, 4, 8}) + (18 * 60 + 21) / 1440.0;
+		if (hc_compute_new_moons(5784, 1, 1, &m) != 0 || fabs(m.conjunction - at) > 2 / 1440.0) {
+			printf("FAIL anchor new moon of Nisan 5784\n");
+			failures++;
+		}
+	}
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		char buf[64];
+		const int n = hc_format_hebrew(&formats[i].date, formats[i].flags, buf, sizeof(buf));
+		if (formats[i].text == NULL ? n >= 0 : n < 0 || strcmp(buf, formats[i].text) != 0) {
+			printf("FAIL anchor format of %d-%d-%d: \"%s\"\n", formats[i].date.year,
+				formats[i].date.month, formats[i].date.day, buf);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/* xorshift64*, for sampling the whole domain reproducibly */
+static uint64_t next_random(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+/* the ends of the domain convert, and anything past them is rejected */
+static long check_limits(void)
+{
+	static const int bad_years[] = { 0, -1, INT_MIN, HC_MAX_YEAR + 1, INT_MAX };
+	uint64_t seed = 88172645463325252ULL;
+	long failures = 0;
+	hc_date d, back;
+	heb_time t;
+	size_t i, k;
+
+	for (i = 0; i < NUM_CALENDARS; i++) {
+		const hc_calendar_type cal = calendars[i];
+		if (hc_set_abs_date(&d, HC_MAX_ABS_DATE, cal) != 0 || !hc_check(&d)
+				|| d.year > HC_MAX_YEAR || hc_get_abs_date(&d) != HC_MAX_ABS_DATE) {
+			printf("FAIL limits: calendar %d at HC_MAX_ABS_DATE\n", cal);
+			failures++;
+		}
+		if (hc_set_abs_date(&d, HC_MAX_ABS_DATE + 1, cal) == 0 || hc_set_abs_date(&d, 0, cal) == 0
+				|| hc_set_abs_date(&d, INT64_MIN, cal) == 0 || hc_set_abs_date(&d, INT64_MAX, cal) == 0) {
+			printf("FAIL limits: calendar %d accepts an absolute day out of range\n", cal);
+			failures++;
+		}
+		for (k = 0; k < sizeof(bad_years) / sizeof(bad_years[0]); k++) {
+			d = (hc_date){cal, bad_years[k], 1, 1};
+			if (hc_check(&d) || hc_get_abs_date(&d) != -1 || hc_convert(&d, HEBREW) != -1) {
+				printf("FAIL limits: calendar %d accepts year %d\n", cal, bad_years[k]);
+				failures++;
+			}
+		}
+		/* the largest year either converts or is rejected, and never hangs */
+		d = (hc_date){cal, HC_MAX_YEAR, 1, 1};
+		if (hc_convert(&d, GREGORIAN) == 0 && !hc_check(&d)) {
+			printf("FAIL limits: calendar %d at HC_MAX_YEAR\n", cal);
+			failures++;
+		}
+		/* around the last year, a date is valid exactly when it converts */
+		hc_set_abs_date(&back, HC_MAX_ABS_DATE, cal);
+		for (k = 0; k < 3 * 14 * 31; k++) {
+			hc_info info;
+			int valid;
+			d = (hc_date){cal, back.year - 1 + (int)k / (14 * 31), 1 + (int)k / 31 % 14, 1 + (int)k % 31};
+			valid = hc_check(&d);
+			if (valid != (hc_get_abs_date(&d) > 0) || valid != (hc_date_info(&d, &info) == 0)
+					|| valid != (hc_convert(&d, HEBREW) == 0)) {
+				printf("FAIL limits: calendar %d validity of %d-%d-%d near HC_MAX_ABS_DATE\n", cal,
+					back.year - 1 + (int)k / (14 * 31), 1 + (int)k / 31 % 14, 1 + (int)k % 31);
+				failures++;
+				break;
+			}
+		}
+		/* random days all over the domain map back to themselves */
+		for (k = 0; k < 100000; k++) {
+			const hc_abs_day a = 1 + (hc_abs_day)(next_random(&seed) % HC_MAX_ABS_DATE);
+			if (hc_set_abs_date(&d, a, cal) != 0)
+				continue;
+			back = d;
+			if (!hc_check(&d) || hc_get_abs_date(&back) != a) {
+				printf("FAIL limits: calendar %d round trip of abs %lld\n", cal, (long long)a);
+				failures++;
+				break;
+			}
+		}
+	}
+	if (hc_compute_molad(HC_MAX_YEAR + 1, 7, HEBREW, &d, &t) != -1
+			|| hc_compute_molad(5785, 13, HEBREW, &d, &t) != -1
+			|| hc_compute_keviut(INT_MAX, NULL, NULL, NULL, NULL) != -1) {
+		printf("FAIL limits: molad or keviut accepts bad input\n");
+		failures++;
+	}
+	{
+		/* the molad of Tishrei of the year after the last is past HC_MAX_ABS_DATE */
+		hc_new_moon m;
+		hc_set_abs_date(&d, HC_MAX_ABS_DATE, HEBREW);
+		if (hc_compute_new_moons(HC_MAX_YEAR + 1, 7, 1, &m) != -1
+				|| hc_compute_new_moons(d.year + 1, 7, 1, &m) != -1) {
+			printf("FAIL limits: new moons of a year out of range\n");
+			failures++;
+		}
+	}
+	{
+		/* 5785 is a common year, with a short Kislev and a full Cheshvan */
+		static const hc_date bad_info[] = {
+			{HEBREW, 5785, 13, 1}, {HEBREW, 5785, 14, 1}, {HEBREW, 5785, 0, 1},
+			{HEBREW, 5785, 7, 31}, {HEBREW, 5785, 7, 0}, {HEBREW, 5785, 2, 30},
+			{HEBREW, 0, 7, 1}, {HEBREW, HC_MAX_YEAR + 1, 7, 1}, {GREGORIAN, 2023, 2, 29},
+			{NONE, 2024, 1, 1}
+		};
+		hc_info info;
+		for (i = 0; i < sizeof(bad_info) / sizeof(bad_info[0]); i++) {
+			if (hc_date_info(&bad_info[i], &info) != -1) {
+				printf("FAIL limits: hc_date_info accepts %d-%d-%d\n", bad_info[i].year,
+					bad_info[i].month, bad_info[i].day);
+				failures++;
+			}
+		}
+	}
+	{
+		/* a removed calendar is reported as such, not called through */
+		hc_date isl = {ISLAMIC, 1445, 1, 1};
+		hc_register_calendar(ISLAMIC, NULL);
+		if (hc_is_leap_year(1445, ISLAMIC) != 0 || (int)hc_get_day_of_week(&isl) != -1
+				|| hc_get_month_length(1445, 1, ISLAMIC) != -1 || hc_get_abs_date(&isl) != -1) {
+			printf("FAIL limits: removed calendar still answers\n");
+			failures++;
+		}
+		hc_register_calendar(ISLAMIC, &islamic_calendar);
+	}
+	{
+		/* an invalid date is neither sorted nor searched for as some other day */
+		hc_date dates[] = { {GREGORIAN, 2024, 2, 30}, {GREGORIAN, 2024, 1, 5}, {GREGORIAN, 2024, 3, 1} };
+		const hc_date sorted[] = { {GREGORIAN, 2024, 1, 5}, {GREGORIAN, 2024, 3, 1} };
+		if (hc_sort_dates(dates, 3, NULL) != -1 || dates[0].day != 30
+				|| hc_lower_bound(sorted, 2, &dates[0]) != (size_t)-1
+				|| hc_lower_bound(sorted, 2, &(hc_date){HEBREW, 5784, 12, 1}) != 1) {
+			printf("FAIL limits: invalid date sorted or searched for\n");
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/*
+ Zmanim: sunrise and sunset of Jerusalem on a day known from almanacs, and the
+ range and locations entry points giving the same times for every day of a
+ year, at places from the equator to beyond the polar circle.
+ */
+#define ZMANIM_DAYS 366
+#define ZMANIM_TOLERANCE (1 / 3600.0)
+
+static int same_time(const double a, const double b)
+{
+	return (isnan(a) && isnan(b)) || fabs(a - b) < ZMANIM_TOLERANCE;
+}
+
+static long check_zmanim(void)
+{
+	static const hc_location locs[] = {
+		{ 31.778, 35.235, 0, 2 }, { 40.713, -74.006, 10, -5 }, { 0.0, 0.0, 0, 0 },
+		{ -33.869, 151.209, 0, 10 }, { 69.649, 18.956, 0, 1 }, { 78.223, 15.647, 0, 1 },
+	};
+	const int nlocs = (int)(sizeof(locs) / sizeof(locs[0]));
+	const hc_abs_day first = hc_get_abs_date(&(hc_date){GREGORIAN, 2024, 1, 1});
+	hc_zmanim *range = malloc(ZMANIM_DAYS * sizeof(hc_zmanim)), at[sizeof(locs) / sizeof(locs[0])], z;
+	long failures = 0;
+	int i, k;
+
+	/* 2024-06-21 in Jerusalem: sunrise 04:34 and sunset 18:48 at UTC+2 */
+	if (hc_zmanim_locations(locs, 1, first + 172, &z) != 0
+			|| fabs(z.sunrise - (4 + 34 / 60.0)) > 2 / 60.0 || fabs(z.sunset - (18 + 48 / 60.0)) > 2 / 60.0
+			|| !(z.alot < z.sunrise && z.sunrise < z.chatzot && z.chatzot < z.sunset && z.sunset < z.tzeis)) {
+		printf("FAIL zmanim: Jerusalem on 2024-06-21\n");
+		failures++;
+	}
+	for (i = 0; i < nlocs; i++) {
+		if (hc_zmanim_range(&locs[i], first, first + ZMANIM_DAYS - 1, range) != 0) {
+			printf("FAIL zmanim: range at location %d\n", i);
+			failures++;
+			continue;
+		}
+		for (k = 0; k < ZMANIM_DAYS; k++) {
+			hc_zmanim_locations(locs, nlocs, first + k, at);
+			if (!same_time(range[k].alot, at[i].alot) || !same_time(range[k].sunrise, at[i].sunrise)
+					|| !same_time(range[k].chatzot, at[i].chatzot)
+					|| !same_time(range[k].sunset, at[i].sunset)
+					|| !same_time(range[k].tzeis, at[i].tzeis)
+					|| !same_time(range[k].shaah_zmanit, at[i].shaah_zmanit)) {
+				printf("FAIL zmanim: range and locations differ at location %d on day %d\n", i, k);
+				failures++;
+				break;
+			}
+		}
+	}
+	free(range);
+	return failures;
+}
+
+/*
+ Recurring events: hc_expand against a day by day reading of the rules, for
+ days at the end of short months, February 29, Cheshvan and Kislev 30, both
+ Adars and Rosh Chodesh, under every leap policy. The expansion is also
+ resumed in small batches, which must give the same occurrences.
+ */
+#define EXPAND_FIRST_YEAR 1990
+#define EXPAND_YEARS 60
+#define EXPAND_BATCH 7
+
+/* the month of the year a yearly rule falls in, 0 if none, read from the docs */
+static int rule_month(const hc_rule *rule, const int year)
+{
+	const int leap = hc_is_leap_year(year, rule->calendar);
+
+	if (rule->calendar != HEBREW || (rule->month != 12 && rule->month != 13))
+		return rule->month;
+	if (rule->month == 12)
+		return leap && rule->leap_policy == LATER_IF_MISSING ? 13 : 12;
+	if (leap)
+		return 13;
+	return rule->leap_policy == SKIP_MISSING ? 0 : 12;
+}
+
+/* whether a day is an occurrence of a rule */
+static int rule_matches(const hc_rule *rule, const hc_abs_day a)
+{
+	hc_date d, prev;
+	int month, length;
+
+	if (hc_set_abs_date(&d, a, rule->calendar) != 0 || hc_set_abs_date(&prev, a - 1, rule->calendar) != 0)
+		return 0;
+	if (rule->frequency == ROSH_CHODESH_RULE)
+		return (d.day == 1 && d.month != 7) || d.day == 30;
+
+	/* the rule's own day, or the last day of its month lacking it */
+	month = rule->frequency == YEARLY_RULE ? rule_month(rule, d.year) : d.month;
+	length = hc_get_month_length(d.year, d.month, rule->calendar);
+	if (d.month == month && (d.day == rule->day
+			|| (rule->leap_policy == EARLIER_IF_MISSING && rule->day > length && d.day == length)))
+		return 1;
+	/* or the day after the end of the month lacking it */
+	month = rule->frequency == YEARLY_RULE ? rule_month(rule, prev.year) : prev.month;
+	length = hc_get_month_length(prev.year, prev.month, rule->calendar);
+	return rule->leap_policy == LATER_IF_MISSING && prev.month == month && rule->day > length
+		&& prev.day == length;
+}
+
+static long check_expand(void)
+{
+	static const hc_rule rules[] = {
+		{ MONTHLY_RULE, GREGORIAN, 0, 29 }, { MONTHLY_RULE, GREGORIAN, 0, 31 },
+		{ MONTHLY_RULE, JULIAN, 0, 30 }, { MONTHLY_RULE, HEBREW, 0, 30 },
+		{ MONTHLY_RULE, ISLAMIC, 0, 30 }, { YEARLY_RULE, GREGORIAN, 2, 29 },
+		{ YEARLY_RULE, GREGORIAN, 12, 25 }, { YEARLY_RULE, JULIAN, 2, 29 },
+		{ YEARLY_RULE, HEBREW, 8, 30 }, { YEARLY_RULE, HEBREW, 9, 30 },
+		{ YEARLY_RULE, HEBREW, 12, 14 }, { YEARLY_RULE, HEBREW, 12, 30 },
+		{ YEARLY_RULE, HEBREW, 13, 14 }, { YEARLY_RULE, HEBREW, 13, 30 },
+		{ YEARLY_RULE, ISLAMIC, 12, 30 }, { ROSH_CHODESH_RULE, HEBREW },
+	};
+	const hc_abs_day first = hc_get_abs_date(&(hc_date){GREGORIAN, EXPAND_FIRST_YEAR, 1, 1});
+	const hc_abs_day last = hc_get_abs_date(&(hc_date){GREGORIAN, EXPAND_FIRST_YEAR + EXPAND_YEARS, 1, 1}) - 1;
+	const int max_out = (int)(last - first + 1);
+	hc_abs_day *out = malloc(max_out * sizeof(hc_abs_day)), a, from;
+	long failures = 0;
+	size_t r;
+	int p, n, k, got;
+
+	for (r = 0; r < sizeof(rules) / sizeof(rules[0]); r++) {
+		for (p = SKIP_MISSING; p <= LATER_IF_MISSING; p++) {
+			hc_rule rule = rules[r];
+			rule.leap_policy = (hc_leap_policy)p;
+			n = hc_expand(&rule, first, last, out, max_out);
+			for (a = first, k = 0; n >= 0 && a <= last; a++) {
+				if (rule_matches(&rule, a) && (k >= n || out[k++] != a))
+					break;
+			}
+			if (n < 0 || a <= last || k != n) {
+				printf("FAIL expand: rule %zu with policy %d at abs %lld\n", r, p, (long long)a);
+				failures++;
+				continue;
+			}
+			/* resumed from the day after the last occurrence of each batch */
+			for (from = first, k = 0; (got = hc_expand(&rule, from, last, out + k, EXPAND_BATCH)) > 0;
+					from = out[k + got - 1] + 1, k += got)
+				;
+			for (a = first, got = 0; a <= last && got < k; a++)
+				got += rule_matches(&rule, a) && out[got] == a;
+			if (k != n || got != n) {
+				printf("FAIL expand: rule %zu with policy %d resumed in batches\n", r, p);
+				failures++;
+			}
+		}
+	}
+	free(out);
+	return failures;
+}
+
+/*
+ Business days: each day of some decades read off its weekday and Hebrew
+ date, counted up front, and compared with hc_is_business_day, the counts
+ of hc_count_business_days over random ranges, and the days reached by
+ hc_add_business_days, in and out of Israel.
+ */
+#define BUSINESS_FIRST_YEAR 5750
+#define BUSINESS_YEARS 60
+#define BUSINESS_SAMPLES 20000
+
+static int is_working(const hc_abs_day a, const hc_holiday_region region)
+{
+	static const int yom_tov[][3] = {
+		{7, 1, 0}, {7, 2, 0}, {7, 10, 0}, {7, 15, 0}, {7, 16, 1}, {7, 22, 0}, {7, 23, 1},
+		{1, 15, 0}, {1, 16, 1}, {1, 21, 0}, {1, 22, 1}, {3, 6, 0}, {3, 7, 1},
+	};
+	hc_date d;
+	size_t i;
+
+	hc_set_abs_date(&d, a, HEBREW);
+	if ((a - 1) % 7 == SATURDAY)
+		return 0;
+	for (i = 0; i < sizeof(yom_tov) / sizeof(yom_tov[0]); i++) {
+		if (d.month == yom_tov[i][0] && d.day == yom_tov[i][1]
+				&& (!yom_tov[i][2] || region == HOLIDAYS_DIASPORA))
+			return 0;
+	}
+	return 1;
+}
+
+static long check_business(void)
+{
+	const hc_abs_day first = hc_heb_to_abs_date(BUSINESS_FIRST_YEAR, 7, 1);
+	const hc_abs_day last = hc_heb_to_abs_date(BUSINESS_FIRST_YEAR + BUSINESS_YEARS, 7, 1) - 1;
+	const size_t days = (size_t)(last - first + 1);
+	/* working days before each day of the range */
+	hc_abs_day *before = malloc((days + 1) * sizeof(hc_abs_day));
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	long failures = 0;
+	size_t i, k;
+	int region;
+
+	for (region = HOLIDAYS_ISRAEL; region <= HOLIDAYS_DIASPORA; region++) {
+		before[0] = 0;
+		for (i = 0; i < days; i++) {
+			const int working = is_working(first + (hc_abs_day)i, (hc_holiday_region)region);
+			before[i + 1] = before[i] + working;
+			if (hc_is_business_day(first + (hc_abs_day)i, (hc_holiday_region)region) != working) {
+				printf("FAIL business: day %lld in region %d\n", (long long)(first + (hc_abs_day)i), region);
+				failures++;
+				break;
+			}
+		}
+		for (k = 0; k < BUSINESS_SAMPLES; k++) {
+			const size_t from = next_random(&seed) % days, to = from + next_random(&seed) % (days - from);
+			const hc_abs_day n = (hc_abs_day)(next_random(&seed) % 1000);
+			hc_abs_day reached, expect;
+			size_t j;
+
+			if (hc_count_business_days(first + (hc_abs_day)from, first + (hc_abs_day)to,
+					(hc_holiday_region)region) != before[to + 1] - before[from]) {
+				printf("FAIL business: count of [%lld, %lld] in region %d\n", (long long)(first + (hc_abs_day)from),
+					(long long)(first + (hc_abs_day)to), region);
+				failures++;
+				break;
+			}
+			/* the n-th working day after from, if the range has it */
+			for (j = from + 1; j < days && before[j + 1] - before[from + 1] < n; j++)
+				;
+			if (j == days)
+				continue;
+			expect = n == 0 ? first + (hc_abs_day)from : first + (hc_abs_day)j;
+			reached = hc_add_business_days(first + (hc_abs_day)from, n, (hc_holiday_region)region);
+			if (reached != expect) {
+				printf("FAIL business: %lld working days after %lld in region %d\n", (long long)n,
+					(long long)(first + (hc_abs_day)from), region);
+				failures++;
+				break;
+			}
+		}
+	}
+	free(before);
+	return failures;
+}
+
+/*
+ Daf Yomi: pages known from the published calendars, and every day of a
+ range spanning the change of cycle length after the 7th: the range lookup
+ agrees with the single day one, and each day learns the page after the
+ previous day's, or the first page of the next tractate or cycle.
+ */
+#define DAF_FIRST_YEAR 1970
+#define DAF_YEARS 60
+
+static long check_daf_yomi(void)
+{
+	static const struct { hc_date date; hc_daf daf; } known[] = {
+		{ {GREGORIAN, 1923, 9, 11}, {1, 0, 2} },
+		{ {GREGORIAN, 1975, 6, 23}, {7, 39, 73} },
+		{ {GREGORIAN, 1975, 6, 24}, {8, 0, 2} },
+		{ {GREGORIAN, 2020, 1, 4}, {13, 39, 73} },
+		{ {GREGORIAN, 2020, 1, 5}, {14, 0, 2} },
+		{ {GREGORIAN, 2024, 6, 21}, {14, 21, 114} },
+	};
+	const hc_abs_day first = hc_get_abs_date(&(hc_date){GREGORIAN, DAF_FIRST_YEAR, 1, 1});
+	const hc_abs_day last = hc_get_abs_date(&(hc_date){GREGORIAN, DAF_FIRST_YEAR + DAF_YEARS, 1, 1}) - 1;
+	hc_daf *range = malloc((size_t)(last - first + 1) * sizeof(hc_daf)), daf;
+	long failures = 0;
+	hc_abs_day a;
+	size_t i;
+
+	for (i = 0; i < sizeof(known) / sizeof(known[0]); i++) {
+		if (hc_daf_yomi(hc_get_abs_date(&known[i].date), &daf) != 0 || daf.cycle != known[i].daf.cycle
+				|| daf.tractate != known[i].daf.tractate || daf.page != known[i].daf.page) {
+			printf("FAIL daf yomi: %d-%d-%d is not %s %d\n", known[i].date.year, known[i].date.month,
+				known[i].date.day, hc_tractate_name(known[i].daf.tractate), known[i].daf.page);
+			failures++;
+		}
+	}
+	if (hc_daf_yomi_cycle_start(14) != hc_get_abs_date(&known[4].date)
+			|| hc_daf_yomi_cycle_start(8) != hc_get_abs_date(&known[2].date)) {
+		printf("FAIL daf yomi: start of cycles 8 and 14\n");
+		failures++;
+	}
+	if (hc_daf_yomi_range(first, last, range) != 0) {
+		printf("FAIL daf yomi: range\n");
+		failures++;
+	}
+	for (a = first; failures == 0 && a <= last; a++) {
+		const hc_daf *d = &range[a - first], *prev = d - 1;
+		if (hc_daf_yomi(a, &daf) != 0 || daf.cycle != d->cycle || daf.tractate != d->tractate
+				|| daf.page != d->page) {
+			printf("FAIL daf yomi: range and single day differ at abs %lld\n", (long long)a);
+			failures++;
+		} else if (a > first && !(d->cycle == prev->cycle && d->tractate == prev->tractate
+				&& d->page == prev->page + 1) && !(d->cycle == prev->cycle
+				&& d->tractate == prev->tractate + 1) && !(d->cycle == prev->cycle + 1
+				&& d->tractate == 0 && d->page == 2 && prev->tractate == 39)) {
+			printf("FAIL daf yomi: abs %lld does not follow the day before\n", (long long)a);
+			failures++;
+		}
+	}
+	free(range);
+	return failures;
+}
+
+/*
+ Keviut index: for every query over the values each field can take, or -1,
+ the years counted and listed from the index are those whose keviut, from
+ hc_compute_keviut, matches. Listing is resumed in small batches.
+ */
+#define KEVIUT_FIRST_YEAR 4990
+#define KEVIUT_LAST_YEAR 7012
+#define KEVIUT_BATCH 5
+
+static long check_keviut_index(void)
+{
+	const int nyears = KEVIUT_LAST_YEAR - KEVIUT_FIRST_YEAR + 1;
+	int (*keviut)[4] = malloc((nyears + 1) * sizeof(*keviut)), *years = malloc(nyears * sizeof(int));
+	hc_keviut_index index;
+	hc_keviut_query q;
+	long failures = 0, count;
+	int batch[KEVIUT_BATCH], y, n, k, i, got, from, same;
+
+	/* row 0 is the year before the range, for previous_leap */
+	for (y = 0; y <= nyears; y++)
+		hc_compute_keviut(KEVIUT_FIRST_YEAR - 1 + y, &keviut[y][0], &keviut[y][1], &keviut[y][2],
+			&keviut[y][3]);
+	if (hc_keviut_index_init(&index, KEVIUT_FIRST_YEAR, KEVIUT_LAST_YEAR) != 0) {
+		printf("FAIL keviut index: cannot build\n");
+		free(keviut);
+		free(years);
+		return 1;
+	}
+	for (q.rosh_hashana_dow = -1; q.rosh_hashana_dow <= SATURDAY; q.rosh_hashana_dow++)
+	for (q.pesach_dow = -1; q.pesach_dow <= SATURDAY; q.pesach_dow++)
+	for (q.ck = -1; q.ck <= 2; q.ck++)
+	for (q.leap = -1; q.leap <= 1; q.leap++)
+	for (q.previous_leap = -1; q.previous_leap <= 1; q.previous_leap++) {
+		/* the matching years, brute force */
+		for (y = 1, n = 0; y <= nyears; y++) {
+			if ((q.rosh_hashana_dow < 0 || keviut[y][0] == q.rosh_hashana_dow)
+					&& (q.pesach_dow < 0 || keviut[y][1] == q.pesach_dow)
+					&& (q.ck < 0 || keviut[y][2] == q.ck) && (q.leap < 0 || keviut[y][3] == q.leap)
+					&& (q.previous_leap < 0 || keviut[y - 1][3] == q.previous_leap))
+				years[n++] = KEVIUT_FIRST_YEAR - 1 + y;
+		}
+		count = hc_keviut_count(&index, &q);
+		same = 1;
+		for (from = KEVIUT_FIRST_YEAR, k = 0; (got = hc_keviut_find(&index, &q, from, batch,
+				KEVIUT_BATCH)) > 0; from = batch[got - 1] + 1) {
+			for (i = 0; i < got; i++)
+				same &= k < n && batch[i] == years[k++];
+		}
+		if (count != n || k != n || !same || got != 0) {
+			printf("FAIL keviut index: query %d %d %d %d %d matches %d years, counted %ld\n",
+				q.rosh_hashana_dow, q.pesach_dow, q.ck, q.leap, q.previous_leap, n, count);
+			failures++;
+		}
+	}
+	hc_keviut_index_free(&index);
+	free(keviut);
+	free(years);
+	return failures;
+}
+
+/*
+ iCalendar output: a feed with a fixed name and rule is written to memory.
+ Every physical line ends in CRLF and is at most 75 octets, a folded line does
+ not start inside a UTF-8 character, and once unfolded the name and summary
+ have their commas, semicolons, backslashes and newlines escaped.
+ */
+#define ICS_OUTPUT 8192
+#define ICS_LINE 75
+
+typedef struct ics_buffer_s {
+	char data[ICS_OUTPUT];
+	size_t len;
+} ics_buffer;
+
+static int ics_buffer_sink(const char *data, const size_t len, void *ctx)
+{
+	ics_buffer *b = ctx;
+
+	if (b->len + len > sizeof(b->data))
+		return -1;
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+	return 0;
+}
+
+static long check_ics(void)
+{
+	static const char name[] = "Family, dates; \\ yahrzeits\nand more";
+	static const char name_text[] = "X-WR-CALNAME:Family\\, dates\\; \\\\ yahrzeits\\nand more";
+	static const char summary[] = "Yahrzeit; Moshe, son of Yaakov \\ Rivka\n"
+		"משה בן יעקב ורבקה, זכרונם לברכה; יום השנה לפטירתו של אבינו";
+	static const char summary_text[] = "SUMMARY:Yahrzeit\\; Moshe\\, son of Yaakov \\\\ Rivka\\n"
+		"משה בן יעקב ורבקה\\, זכרונם לברכה\\; יום השנה לפטירתו של אבינו";
+	const hc_rule rule = {YEARLY_RULE, GREGORIAN, 1, 1, SKIP_MISSING};
+	const hc_abs_day from = hc_get_abs_date(&(hc_date){GREGORIAN, 2024, 1, 1});
+	static ics_buffer out;
+	static char unfolded[ICS_OUTPUT];
+	hc_ics_writer w;
+	long failures = 0;
+	size_t pos = 0, n = 0;
+	int seen = 0, folds = 0;
+
+	out.len = 0;
+	if (hc_ics_begin(&w, ics_buffer_sink, &out, name) != 0 || hc_ics_add_rule(&w, &rule, summary,
+			from, from + 365) != 0 || hc_ics_end(&w) != 0) {
+		printf("FAIL ics: cannot write the feed\n");
+		return 1;
+	}
+	while (pos < out.len) {
+		const char *eol = memchr(out.data + pos, '\r', out.len - pos);
+		const size_t end = eol != NULL ? (size_t)(eol - out.data) : out.len;
+
+		if (eol == NULL || end + 1 >= out.len || eol[1] != '\n' || end - pos > ICS_LINE
+				|| memchr(out.data + pos, '\n', end - pos) != NULL) {
+			printf("FAIL ics: line at octet %zu is not a content line of at most %d octets\n",
+				pos, ICS_LINE);
+			return failures + 1;
+		}
+		if (out.data[pos] == ' ') {
+			if (end - pos < 2 || ((unsigned char)out.data[pos + 1] & 0xC0) == 0x80) {
+				printf("FAIL ics: line folded inside a character at octet %zu\n", pos);
+				failures++;
+			}
+			folds++;
+			pos++;
+		} else if (n > 0) {
+			/* a whole logical line has been unfolded */
+			unfolded[n] = '\0';
+			seen += strcmp(unfolded, name_text) == 0;
+			seen += strcmp(unfolded, summary_text) == 0;
+			n = 0;
+		}
+		memcpy(unfolded + n, out.data + pos, end - pos);
+		n += end - pos;
+		pos = end + 2;
+	}
+	if (seen != 2 || folds < 2) {
+		printf("FAIL ics: escaped name and summary found %d of 2 times, %d folds\n", seen, folds);
+		failures++;
+	}
+	return failures;
+}
+
+/*
+ Worst case latency: conversions of days from the start of the calendar up to
+ HC_MAX_ABS_DATE, by order of magnitude. Each class is timed as the best of
+ several runs, to leave out noise from the machine; the slowest class may not
+ be more than LATENCY_RATIO times the fastest.
+ */
+#define LATENCY_SAMPLES 2000
+#define LATENCY_RUNS 7
+#define LATENCY_RATIO 4.0
+
+static double time_class(const hc_abs_day low, const hc_abs_day high, uint64_t *seed)
+{
+	static hc_abs_day days[LATENCY_SAMPLES];
+	double best = 0;
+	hc_date d;
+	int run, k;
+	size_t i;
+
+	for (k = 0; k < LATENCY_SAMPLES; k++)
+		days[k] = low + (hc_abs_day)(next_random(seed) % (uint64_t)(high - low + 1));
+	for (run = 0; run < LATENCY_RUNS; run++) {
+		struct timespec t0, t1;
+		double ns;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (k = 0; k < LATENCY_SAMPLES; k++) {
+			for (i = 0; i < NUM_CALENDARS; i++) {
+				if (hc_set_abs_date(&d, days[k], calendars[i]) == 0)
+					hc_get_abs_date(&d);
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / LATENCY_SAMPLES;
+		if (run == 0 || ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+static long check_latency(void)
+{
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	double fastest = 0, slowest = 0;
+	hc_abs_day low;
+
+	for (low = 1000000; low < HC_MAX_ABS_DATE; low *= 10) {
+		const hc_abs_day high = low * 10 - 1 < HC_MAX_ABS_DATE ? low * 10 - 1 : HC_MAX_ABS_DATE;
+		const double ns = time_class(low, high, &seed);
+		printf("latency        [%lld, %lld]: %.0f ns per day in %d calendars\n", (long long)low, (long long)high, ns, NUM_CALENDARS);
+		if (fastest == 0 || ns < fastest)
+			fastest = ns;
+		if (ns > slowest)
+			slowest = ns;
+	}
+	if (slowest > LATENCY_RATIO * fastest) {
+		printf("FAIL latency: slowest range %.1f times the fastest\n", slowest / fastest);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ The result cache: calls from a working set larger than the cache, some of
+ them invalid, must give the same results with the cache on as with it off,
+ through hits, misses and evictions alike, and nested calls (the molad in a
+ calendar other than Hebrew converts a date) must not disturb each other.
+ */
+#define CACHE_CALLS 300000
+#define CACHE_WORKING_SET (2 * HC_CACHE_SLOTS)
+
+static long check_cache(void)
+{
+	uint64_t seed = 0xD1B54A32D192ED03ULL;
+	hc_cache_stats stats;
+	long failures = 0;
+	int k;
+
+	hc_cache_clear();
+	for (k = 0; k < CACHE_CALLS; k++) {
+		/* the same inputs come back, out of a fixed working set */
+		uint64_t r = next_random(&seed) % CACHE_WORKING_SET * 0x9E3779B97F4A7C15ULL;
+		const hc_calendar_type from = calendars[r % NUM_CALENDARS];
+		const hc_calendar_type to = calendars[(r >> 8) % NUM_CALENDARS];
+		const int year = (int)((r >> 16) % 3000) + (from == HEBREW ? 4000 : 1000);
+		const int month = (int)((r >> 32) % 14), day = (int)((r >> 40) % 32);
+		hc_date a = { from, year, month, day }, b = a, da, db;
+		heb_time ta, tb;
+		int ka[4], kb[4], ra, rb;
+
+		switch ((r >> 48) % 3) {
+		case 0:
+			hc_cache_enable(1);
+			ra = hc_convert(&a, to);
+			hc_cache_enable(0);
+			rb = hc_convert(&b, to);
+			if (ra != rb || !same_date(&a, &b))
+				failures++;
+			break;
+		case 1:
+			hc_cache_enable(1);
+			ra = hc_compute_molad(year, month, to, &da, &ta);
+			hc_cache_enable(0);
+			rb = hc_compute_molad(year, month, to, &db, &tb);
+			if (ra != rb || (ra == 0 && (!same_date(&da, &db) || ta.hour != tb.hour
+					|| ta.part != tb.part)))
+				failures++;
+			break;
+		default:
+			hc_cache_enable(1);
+			ra = hc_compute_keviut(year, &ka[0], &ka[1], &ka[2], &ka[3]);
+			hc_cache_enable(0);
+			rb = hc_compute_keviut(year, &kb[0], &kb[1], &kb[2], &kb[3]);
+			if (ra != rb || (ra == 0 && memcmp(ka, kb, sizeof(ka)) != 0))
+				failures++;
+		}
+	}
+	hc_cache_get_stats(&stats);
+	printf("cache          %lu lookups, %lu hits (%.1f%%), %lu evictions\n", stats.lookups, stats.hits,
+		100.0 * stats.hits / stats.lookups, stats.evictions);
+	if (failures || stats.hits == 0 || stats.evictions == 0) {
+		printf("FAIL cache: %ld results differ from uncached ones\n", failures);
+		failures++;
+	}
+
+	/* registering a calendar drops what was cached */
+	{
+		hc_date d = { GREGORIAN, 2024, 3, 11 };
+		unsigned long hits;
+		hc_cache_enable(1);
+		hc_convert(&d, HEBREW);
+		hc_register_calendar(GREGORIAN, &greg_calendar);
+		hc_cache_get_stats(&stats);
+		hits = stats.hits;
+		d = (hc_date){ GREGORIAN, 2024, 3, 11 };
+		hc_convert(&d, HEBREW);
+		hc_cache_get_stats(&stats);
+		if (stats.hits != hits) {
+			printf("FAIL cache: result kept after a calendar was registered\n");
+			failures++;
+		}
+	}
+	hc_cache_enable(0);
+	hc_cache_clear();
+	return failures;
+}
+
+/*
+ The columnar codec, on every day of the range in order and on a synthetic
+ feed of event dates: clustered, mostly sorted, with duplicates and some
+ late records. Both must come back unchanged through storing and loading,
+ decoding to each calendar and range scans, and the feed must compress to
+ no more than an eighth of its days as plain 64-bit days.
+ */
+#define COLUMN_EVENTS 1000000
+#define COLUMN_MIN_RATIO 8.0
+
+static long check_column_of(const char *what, const hc_abs_day *days, const size_t rows)
+{
+	static const hc_calendar_type cals[] = { GREGORIAN, JULIAN, HEBREW, ISLAMIC };
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	hc_column col, loaded, bad;
+	unsigned char *stored;
+	hc_abs_day *back = malloc(rows * sizeof(hc_abs_day));
+	hc_date *dates = malloc(rows * sizeof(hc_date)), d;
+	size_t size, i, k, *found = malloc(rows * sizeof(size_t));
+	struct timespec t0, t1;
+	double ratio, seconds;
+	long failures = 0;
+	int n, c;
+
+	if (hc_column_encode_abs(&col, days, rows) != 0) {
+		printf("FAIL column: cannot encode %s\n", what);
+		return 1;
+	}
+	size = hc_column_stored_size(&col);
+	stored = malloc(size);
+	if (hc_column_store(&col, stored) != size || hc_column_load(&loaded, stored, size) != 0
+			|| hc_column_load(&bad, stored, size - 1) == 0) {
+		printf("FAIL column: %s does not store and load\n", what);
+		failures++;
+	}
+	hc_column_free(&col);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	n = hc_column_decode_abs(&loaded, 0, back, (int)rows);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	if (n != (int)rows || memcmp(back, days, rows * sizeof(hc_abs_day)) != 0) {
+		printf("FAIL column: %s decodes to other days\n", what);
+		failures++;
+	}
+	ratio = (double)(rows * sizeof(hc_abs_day)) / size;
+	printf("column         %s: %zu rows in %zu bytes, %.1f times smaller, decoded at %.1f GB/s\n",
+		what, rows, size, ratio, rows * sizeof(hc_abs_day) / seconds / 1e9);
+
+	for (c = 0; c < (int)(sizeof(cals) / sizeof(cals[0])); c++) {
+		/* a start in mid block, and dates from before a calendar began left out */
+		for (k = 0; k < rows && hc_set_abs_date(&d, days[k], cals[c]) != 0; k++)
+			;
+		for (i = k; i < rows; i++) {
+			if (hc_set_abs_date(&d, days[i], cals[c]) != 0)
+				break;
+		}
+		/* only calendars that have all the days from one of them on */
+		if (i < rows || k + 1 >= rows)
+			continue;
+		n = hc_column_decode(&loaded, k + 1, cals[c], dates, (int)rows);
+		for (i = k + 1; n == (int)(rows - k - 1) && i < rows; i++) {
+			hc_set_abs_date(&d, days[i], cals[c]);
+			if (!same_date(&d, &dates[i - k - 1]))
+				break;
+		}
+		if (n != (int)(rows - k - 1) || i < rows) {
+			printf("FAIL column: %s decodes to other dates of calendar %d\n", what, cals[c]);
+			failures++;
+		}
+	}
+
+	for (k = 0; k < 20; k++) {
+		const hc_abs_day from = days[next_random(&seed) % rows];
+		const hc_abs_day to = from + (hc_abs_day)(next_random(&seed) % 400);
+		size_t start = next_random(&seed) % rows, expect = 0;
+		for (i = start; i < rows; i++)
+			expect += days[i] >= from && days[i] <= to;
+		/* in pieces, resuming one past the last row found */
+		while ((n = hc_column_scan(&loaded, from, to, start, found, HEBREW, dates, 1000)) > 0) {
+			for (i = 0; i < (size_t)n; i++) {
+				hc_set_abs_date(&d, days[found[i]], HEBREW);
+				if (found[i] < start || days[found[i]] < from || days[found[i]] > to
+						|| !same_date(&d, &dates[i]))
+					break;
+			}
+			if (i < (size_t)n)
+				break;
+			expect -= n;
+			start = found[n - 1] + 1;
+		}
+		if (n != 0 || expect != 0) {
+			printf("FAIL column: %s scan of [%lld, %lld]\n", what, (long long)from, (long long)to);
+			failures++;
+			break;
+		}
+	}
+
+	hc_column_free(&loaded);
+	free(stored);
+	free(back);
+	free(dates);
+	free(found);
+	return failures;
+}
+
+static long check_column(const hc_abs_day first, const hc_abs_day last)
+{
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	const size_t days_rows = (size_t)(last - first + 1);
+	hc_abs_day *days = malloc((days_rows > COLUMN_EVENTS ? days_rows : COLUMN_EVENTS) * sizeof(hc_abs_day));
+	long failures;
+	hc_abs_day day = HC_COMMON_BEGINNING + 730000;
+	size_t i;
+
+	for (i = 0; i < days_rows; i++)
+		days[i] = first + (hc_abs_day)i;
+	failures = check_column_of("all days", days, days_rows);
+
+	/* a few events a day, and one in a thousand arriving up to a week late */
+	for (i = 0; i < COLUMN_EVENTS; i++) {
+		const uint64_t r = next_random(&seed);
+		day += r % 4 == 0;
+		days[i] = r % 1000 == 1 ? day - (hc_abs_day)(r >> 32) % 8 : day;
+	}
+	{
+		hc_column col;
+		hc_column_encode_abs(&col, days, COLUMN_EVENTS);
+		if ((double)COLUMN_EVENTS * sizeof(hc_abs_day) / hc_column_stored_size(&col) < COLUMN_MIN_RATIO) {
+			printf("FAIL column: events compress less than %.0f times\n", COLUMN_MIN_RATIO);
+			failures++;
+		}
+		hc_column_free(&col);
+	}
+	failures += check_column_of("events", days, COLUMN_EVENTS);
+	free(days);
+
+	/* headers cut short or with counts of rows that do not match the blocks */
+	{
+		static const uint64_t headers[][2] = {
+			{ UINT64_MAX, 0 }, { UINT64_MAX - 254, 0 }, { 1, 0 }, { 0, 1 }, { 257, 1 },
+		};
+		unsigned char stored[20 + 33 + 8] = { 'H', 'C', 'C', '1' };
+		hc_column bad;
+		size_t h;
+		int b;
+
+		if (hc_column_load(&bad, stored, 19) == 0) {
+			printf("FAIL column: truncated header loads\n");
+			failures++;
+		}
+		for (h = 0; h < sizeof(headers) / sizeof(headers[0]); h++) {
+			for (b = 0; b < 8; b++) {
+				stored[4 + b] = (unsigned char)(headers[h][0] >> (8 * b));
+				stored[12 + b] = (unsigned char)(headers[h][1] >> (8 * b));
+			}
+			if (hc_column_load(&bad, stored, 20) == 0 || hc_column_load(&bad, stored, 20 + 33) == 0
+					|| hc_column_load(&bad, stored, sizeof(stored)) == 0) {
+				printf("FAIL column: header of %llu rows in %llu blocks loads\n",
+						(unsigned long long)headers[h][0], (unsigned long long)headers[h][1]);
+				failures++;
+			}
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	hc_abs_day first = 2, last;
+	long total_checked = 0, total_failures;
+	int threads, i, k;
+	pthread_t *tids;
+	chunk *chunks;
+	struct timespec t0, t1;
+
+	last = hc_heb_to_abs_date(DEFAULT_LAST_HEB_YEAR, 7, 1) - 1;
+	if (argc > 1)
+		first = strtoll(argv[1], NULL, 0);
+	if (argc > 2)
+		last = strtoll(argv[2], NULL, 0);
+	if (first < 2 || last < first) {
+		fprintf(stderr, "usage: %s [first_abs_day [last_abs_day]]\n", argv[0]);
+		return 2;
+	}
+
+	threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads < 1)
+		threads = 1;
+	if (threads > last - first + 1)
+		threads = (int)(last - first + 1);
+	tids = malloc(threads * sizeof(pthread_t));
+	chunks = calloc(threads, sizeof(chunk));
+
+	total_failures = check_anchors() + check_limits() + check_zmanim() + check_expand()
+		+ check_business() + check_daf_yomi() + check_keviut_index() + check_ics() + check_latency()
+		+ check_column(first, last) + check_cache();
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < threads; i++) {
+		chunks[i].first = first + (last - first + 1) * i / threads;
+		chunks[i].last = first + (last - first + 1) * (i + 1) / threads - 1;
+		pthread_create(&tids[i], NULL, run_chunk, &chunks[i]);
+	}
+	for (i = 0; i < threads; i++)
+		pthread_join(tids[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (k = 0; k < NUM_CHECKS; k++) {
+		long f = 0;
+		for (i = 0; i < threads; i++)
+			f += chunks[i].failures[k];
+		printf("%-14s %s (%ld failures)\n", check_names[k], f ? "FAIL" : "ok", f);
+		total_failures += f;
+	}
+	for (i = 0; i < threads; i++)
+		total_checked += chunks[i].checked;
+	printf("%ld days [%lld, %lld] on %d threads in %.2f s: %s\n", total_checked,
+		(long long)first, (long long)last, threads,
+		(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9,
+		total_failures ? "FAILED" : "PASSED");
+
+	free(tids);
+	free(chunks);
+	return total_failures ? 1 : 0;
+}